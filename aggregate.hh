@@ -0,0 +1,82 @@
+/****************************************************************************
+ *
+ * aggregate.hh - aggregate a value of the intervals overlapping each interval
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef AGGREGATE_HH
+#define AGGREGATE_HH
+
+#include <vector>
+#include "interval_set.hh"
+#include "workspace.hh"
+#include "endpoint.hh"
+
+/******************************************************************************
+ * Aggregation operators. An operator maps the value of each interval
+ * of B to an element of a commutative group (lift), and combines
+ * elements with the group operation (combine), whose inverse is
+ * given by inverse. This is what the prefix-sum trick used to count
+ * the intersections requires: the aggregate over the intervals of B
+ * that overlap [l, r] is the aggregate over the left endpoints of B
+ * up to r, combined with the inverse of the aggregate over the right
+ * endpoints of B before l.
+ *
+ * With floating-point values, the result is subject to the rounding
+ * errors of the prefix sums.
+ ******************************************************************************/
+
+// Sum of the values
+template<typename T>
+struct sum_op {
+    typedef T value_type;
+
+    GLOBAL static T identity( void ) { return T(0); }
+    GLOBAL static T lift( T v ) { return v; }
+    GLOBAL static T combine( T a, T b ) { return a + b; }
+    GLOBAL static T inverse( T a ) { return -a; }
+};
+
+// Sum of the squares of the values
+template<typename T>
+struct sum_of_squares_op : public sum_op<T> {
+    GLOBAL static T lift( T v ) { return v*v; }
+};
+
+/**
+ * Store in result[i] the aggregate, according to operator Op, of the
+ * values of the intervals in `B` that overlap the interval with ID i
+ * of `A`; `values[j]` is the value of the interval with ID j of `B`.
+ * With Op = sum_op<T> and all values equal to one, result[i] is the
+ * number of intersections of i. Return the aggregate over all
+ * intervals of A. The temporary arrays are taken from `ws`, if not
+ * NULL.
+ *
+ * The function is provided by the same backends as
+ * count_intersections(), for int32_t and int64_t coordinates and for
+ * sum_op<int64_t>, sum_op<double> and sum_of_squares_op<double>.
+ */
+template<typename Coord, typename Op>
+typename Op::value_type aggregate_intersections( const interval_set<Coord> &A,
+                                                 const interval_set<Coord> &B,
+                                                 const std::vector<typename Op::value_type> &values,
+                                                 std::vector<typename Op::value_type> &result,
+                                                 count_workspace *ws = NULL );
+
+#endif /* AGGREGATE_HH */
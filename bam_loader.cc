@@ -0,0 +1,136 @@
+/****************************************************************************
+ *
+ * bam_loader.cc - pipelined loading of BAM files
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+#include <iostream>
+#include "bam_loader.hh"
+
+// number of records decoded between two checks for a contig change
+static const int BATCH_SIZE = 4096;
+
+bam_loader::bam_loader() :
+    fp(NULL), hdr(NULL), pool(NULL), done(false), error(false)
+{ }
+
+bam_loader::~bam_loader()
+{
+    if (reader.joinable())
+        reader.join();
+    if (hdr != NULL)
+        bam_hdr_destroy(hdr);
+    if (fp != NULL)
+        sam_close(fp);
+    if (pool != NULL)
+        hts_tpool_destroy(pool);
+}
+
+bool bam_loader::open( const char *fname, int n_threads )
+{
+    fp = hts_open(fname, "r");
+    if (fp == NULL)
+        return false;
+    if (n_threads > 0) {
+        pool = hts_tpool_init(n_threads);
+        if (pool != NULL) {
+            htsThreadPool p = { pool, 0 };
+            hts_set_thread_pool(fp, &p);
+        }
+    }
+    hdr = sam_hdr_read(fp);
+    if (hdr == NULL)
+        return false;
+    names.clear();
+    for (int32_t tid = 0; tid < hdr->n_targets; tid++) {
+        names.push_back(hdr->target_name[tid]);
+    }
+    return true;
+}
+
+void bam_loader::start( void )
+{
+    reader = std::thread(&bam_loader::run, this);
+}
+
+void bam_loader::push( int32_t tid, interval_set<int32_t> &alignments )
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    ready.push_back(std::make_pair(tid, interval_set<int32_t>()));
+    ready.back().second.swap(alignments);
+    cond.notify_one();
+}
+
+void bam_loader::run( void )
+{
+    std::vector<bam1_t*> batch(BATCH_SIZE);
+    for (int i=0; i<BATCH_SIZE; i++) {
+        batch[i] = bam_init1();
+    }
+
+    std::vector<bool> seen(names.size(), false);
+    interval_set<int32_t> cur;
+    int32_t cur_tid = -1;
+    bool eof = false, unsorted = false;
+
+    while (!eof && !unsorted) {
+        int n_read = 0;
+        while (n_read < BATCH_SIZE && sam_read1(fp, hdr, batch[n_read]) > 0) {
+            n_read++;
+        }
+        eof = (n_read < BATCH_SIZE);
+
+        for (int k=0; k<n_read && !unsorted; k++) {
+            const bam1_core_t &c = batch[k]->core;
+            if (c.tid != cur_tid) {
+                if (cur_tid >= 0)
+                    push(cur_tid, cur);
+                cur_tid = c.tid;
+                if (cur_tid >= 0) {
+                    unsorted = seen[cur_tid];
+                    seen[cur_tid] = true;
+                }
+            }
+            if (cur_tid < 0)
+                continue;       // unmapped read
+            cur.push_back(c.pos + 1, c.pos + c.l_qseq);
+        }
+    }
+    if (!unsorted && cur_tid >= 0)
+        push(cur_tid, cur);
+
+    for (int i=0; i<BATCH_SIZE; i++) {
+        bam_destroy1(batch[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    error = unsorted;
+    done = true;
+    cond.notify_one();
+}
+
+bool bam_loader::next( int32_t &tid, interval_set<int32_t> &alignments )
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    cond.wait(lock, [this]{ return done || !ready.empty(); });
+    if (ready.empty() || error)
+        return false;
+    tid = ready.front().first;
+    alignments.swap(ready.front().second);
+    ready.pop_front();
+    return true;
+}
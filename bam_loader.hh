@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ * bam_loader.hh - pipelined loading of BAM files
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef BAM_LOADER_HH
+#define BAM_LOADER_HH
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "interval_set.hh"
+
+extern "C" {
+#include <htslib/sam.h>
+}
+
+/**
+ * Loads the alignments of a coordinate-sorted BAM file in a
+ * background thread, and hands them over one contig at a time, as
+ * soon as all the alignments of that contig have been read. The
+ * BGZF blocks are decompressed by a pool of htslib threads. This
+ * allows the alignments of contig k to be processed while contig
+ * k+1 is being decoded.
+ */
+class bam_loader {
+public:
+    bam_loader();
+    ~bam_loader();
+
+    /**
+     * Open the BAM file `fname` and read its header; `n_threads` is
+     * the number of decompression threads. Return false on error.
+     */
+    bool open( const char *fname, int n_threads );
+
+    /**
+     * Names of the contigs; the ID of each contig is its index.
+     */
+    const std::vector<std::string> &contig_names( void ) const { return names; }
+
+    /**
+     * Start loading the alignments in the background.
+     */
+    void start( void );
+
+    /**
+     * Wait until all the alignments of the next contig are available,
+     * and move them to `alignments`; `tid` is set to the ID of the
+     * contig. Unmapped reads are skipped. Return false when there
+     * are no more contigs, or if an error occurred (see failed()).
+     */
+    bool next( int32_t &tid, interval_set<int32_t> &alignments );
+
+    /**
+     * Return true if loading stopped because of an error (e.g.,
+     * the BAM file is not sorted by coordinate).
+     */
+    bool failed( void ) const { return error; }
+
+private:
+    bam_loader( const bam_loader & );
+    bam_loader& operator=( const bam_loader & );
+
+    void run( void );
+    void push( int32_t tid, interval_set<int32_t> &alignments );
+
+    samFile *fp;
+    bam_hdr_t *hdr;
+    hts_tpool *pool;
+    std::vector<std::string> names;
+
+    std::thread reader;
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::deque< std::pair< int32_t, interval_set<int32_t> > > ready;
+    bool done;
+    bool error;
+};
+
+#endif /* BAM_LOADER_HH */
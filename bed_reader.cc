@@ -0,0 +1,242 @@
+/****************************************************************************
+ *
+ * bed_reader.cc - parallel BED file reader
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+#include <cstring>
+#include <omp.h>
+#include "bed_reader.hh"
+#include "mapped_file.hh"
+
+/**
+ * FNV-1a hash of the `len` characters starting at `s`
+ */
+static uint64_t hash_name( const char *s, size_t len )
+{
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i=0; i<len; i++) {
+        h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
+contig_table::contig_table( const std::vector<std::string> &names ) :
+    n_contigs(names.size())
+{
+    size_t size = 16;
+    while (size < 4*names.size())
+        size *= 2;
+    table.resize(size);
+    mask = size - 1;
+    for (size_t i=0; i<size; i++) {
+        table[i].tid = -1;
+    }
+    for (size_t tid=0; tid<names.size(); tid++) {
+        insert(names[tid], tid);
+    }
+    /* Aliases with the "chr" prefix added (e.g., "chr20" for "20")
+       or removed (e.g., "20" for "chr20"); they do not override real
+       contig names */
+    for (size_t tid=0; tid<names.size(); tid++) {
+        const std::string &name = names[tid];
+        const std::string alias = (name.compare(0, 3, "chr") == 0 ? name.substr(3) : "chr" + name);
+        if (!alias.empty() && lookup(alias.data(), alias.size()) < 0)
+            insert(alias, tid);
+    }
+}
+
+void contig_table::insert( const std::string &name, int32_t tid )
+{
+    size_t i = hash_name(name.data(), name.size()) & mask;
+    while (table[i].tid >= 0 && table[i].name != name)
+        i = (i + 1) & mask;
+    table[i].name = name;
+    table[i].tid = tid;
+}
+
+int32_t contig_table::lookup( const char *name, size_t len ) const
+{
+    size_t i = hash_name(name, len) & mask;
+    while (table[i].tid >= 0) {
+        const std::string &s = table[i].name;
+        if (s.size() == len && !memcmp(s.data(), name, len))
+            return table[i].tid;
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+/**
+ * Parse a (possibly negative) decimal integer starting at `*p` and
+ * ending before `end`; leading blanks are skipped. On success, store
+ * the result in `v`, advance `*p` past the last digit and return
+ * true.
+ */
+static bool parse_int( const char **p, const char *end, int32_t &v )
+{
+    const char *s = *p;
+    while (s < end && (*s == ' ' || *s == '\t'))
+        s++;
+    const bool neg = (s < end && *s == '-');
+    if (neg)
+        s++;
+    const char *digits = s;
+    int64_t x = 0;
+    while (s < end && *s >= '0' && *s <= '9' && x <= INT32_MAX) {
+        x = x*10 + (*s - '0');
+        s++;
+    }
+    if (s == digits || x > INT32_MAX)
+        return false;
+    v = (neg ? -x : x);
+    *p = s;
+    return true;
+}
+
+/**
+ * Return a pointer to the first character after the end of the line
+ * containing `p`, or `end`.
+ */
+static const char *next_line( const char *p, const char *end )
+{
+    const char *nl = static_cast<const char*>(memchr(p, '\n', end - p));
+    return (nl == NULL ? end : nl + 1);
+}
+
+/**
+ * Parse the lines in [begin, end), appending the intervals of contig
+ * tid to `out[tid]`. Return 0 on success, or the offset (plus one)
+ * of the first malformed line.
+ */
+static size_t parse_chunk( const char *base,
+                           const char *begin,
+                           const char *end,
+                           const contig_table &contigs,
+                           std::vector< std::vector<interval> > &out )
+{
+    const char *last_name = NULL;
+    size_t last_len = 0;
+    int32_t last_tid = -1;
+
+    for (const char *line = begin; line < end; line = next_line(line, end)) {
+        const char *p = line;
+        while (p < end && *p != '\t' && *p != ' ' && *p != '\n' && *p != '\r')
+            p++;
+        const size_t len = p - line;
+        if (len == 0 || *line == '#' ||
+            (len == 5 && !memcmp(line, "track", 5)) ||
+            (len == 7 && !memcmp(line, "browser", 7)))
+            continue;
+        /* BED files are usually sorted by contig, so most lines
+           refer to the same contig as the previous one */
+        if (len != last_len || memcmp(line, last_name, len)) {
+            last_name = line;
+            last_len = len;
+            last_tid = contigs.lookup(line, len);
+        }
+        interval i;
+        if (last_tid < 0 ||
+            !parse_int(&p, end, i.left) ||
+            !parse_int(&p, end, i.right))
+            return line - base + 1;
+        i.id = 0;
+        i.payload = 0;
+        out[last_tid].push_back(i);
+    }
+    return 0;
+}
+
+/**
+ * Return a pointer to the beginning of chunk k of the n_chunks
+ * chunks of [base, end). Each chunk starts at the first line that
+ * begins in its share of the bytes.
+ */
+static const char *chunk_start( const char *base, const char *end, int k, int n_chunks )
+{
+    const char *p = base + (size_t)(end - base) * k / n_chunks;
+    if (k == n_chunks)
+        return end;
+    if (p == base)
+        return base;
+    return next_line(p - 1, end);
+}
+
+bool read_bed_file( const char *fname,
+                    const contig_table &contigs,
+                    std::map<int32_t, std::vector<interval> > &targets,
+                    std::string &error )
+{
+    targets.clear();
+    mapped_file file;
+    if (!file.open(fname)) {
+        error = "can not open file";
+        return false;
+    }
+
+    const char *base = file.data();
+    const char *end = base + file.size();
+    const int max_threads = omp_get_max_threads();
+    /* out[c][tid] holds the intervals of contig tid found in chunk
+       c. Chunks are processed in parallel, and merged in order. */
+    std::vector< std::vector< std::vector<interval> > > out(max_threads);
+    std::vector<size_t> bad(max_threads, 0);
+    int n_chunks = 1;
+
+#pragma omp parallel
+    {
+        const int my_id = omp_get_thread_num();
+#pragma omp single
+        n_chunks = omp_get_num_threads();
+
+        const char *my_begin = chunk_start(base, end, my_id, n_chunks);
+        const char *my_end = chunk_start(base, end, my_id + 1, n_chunks);
+        out[my_id].resize(contigs.size());
+        if (my_begin < my_end)
+            bad[my_id] = parse_chunk(base, my_begin, my_end, contigs, out[my_id]);
+    }
+
+    for (int c=0; c<n_chunks; c++) {
+        if (bad[c]) {
+            const char *line = base + bad[c] - 1;
+            const char *eol = line;
+            while (eol < end && *eol != '\n' && *eol != '\r')
+                eol++;
+            error = "malformed line or unknown contig: " + std::string(line, eol - line);
+            return false;
+        }
+    }
+
+    for (size_t tid=0; tid<contigs.size(); tid++) {
+        size_t n = 0;
+        for (int c=0; c<n_chunks; c++) {
+            n += out[c][tid].size();
+        }
+        if (n == 0)
+            continue;
+        std::vector<interval> &t = targets[tid];
+        t.reserve(n);
+        for (int c=0; c<n_chunks; c++) {
+            t.insert(t.end(), out[c][tid].begin(), out[c][tid].end());
+            std::vector<interval>().swap(out[c][tid]);
+        }
+        for (size_t i=0; i<n; i++) {
+            t[i].id = i;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+ *
+ * bed_reader.hh - parallel BED file reader
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef BED_READER_HH
+#define BED_READER_HH
+
+#include <map>
+#include <string>
+#include <vector>
+#include "interval.hh"
+
+/**
+ * Hash table that maps contig names to contig IDs. A BED file may
+ * name a contig with or without the "chr" prefix, regardless of the
+ * convention used by the BAM file; both forms are accepted.
+ */
+class contig_table {
+public:
+    /**
+     * `names[tid]` is the name of the contig with ID tid.
+     */
+    contig_table( const std::vector<std::string> &names );
+
+    /**
+     * Return the ID of the contig whose name is the `len` characters
+     * starting at `name`, or -1 if there is no such contig.
+     */
+    int32_t lookup( const char *name, size_t len ) const;
+
+    /**
+     * Number of contigs
+     */
+    size_t size( void ) const { return n_contigs; }
+
+private:
+    struct entry {
+        std::string name;
+        int32_t tid;            // -1 if the slot is empty
+    };
+
+    void insert( const std::string &name, int32_t tid );
+
+    std::vector<entry> table;   // open addressing, linear probing
+    size_t mask;
+    size_t n_contigs;
+};
+
+/**
+ * Read the target intervals from the BED file `fname`. The file is
+ * mapped in memory and split into chunks that are parsed in
+ * parallel. On exit, `targets` maps the ID of each contig to its
+ * target intervals, in the same order as they appear in the file;
+ * the intervals of each contig are numbered 0, 1, ... Header lines
+ * ("#", "track", "browser") are skipped. Return false on error, and
+ * set `error` to a description of the problem.
+ */
+bool read_bed_file( const char *fname,
+                    const contig_table &contigs,
+                    std::map<int32_t, std::vector<interval> > &targets,
+                    std::string &error );
+
+#endif /* BED_READER_HH */
@@ -0,0 +1,413 @@
+/****************************************************************************
+ *
+ * bench.cc - per-phase micro-benchmark of the counting kernels
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+/*
+ * Measure the wall-clock time of each phase of the counting kernels
+ * (see phases.hh) over a grid of input sizes, overlap densities and
+ * numbers of threads. Each configuration is run `nreps` times after
+ * a warm-up run; the median and the variance of the time of each
+ * phase are written as CSV (one row per configuration) or JSON.
+ *
+ * The same source is compiled once per backend (make bench); the
+ * name of the backend is given by the BENCH_BACKEND macro.
+ *
+ * Example:
+ *
+ * ./bench_stl -n 1000000,10000000 -d 1,10,100 -t 1,2,4,8 -o phases.csv
+ *
+ * The STL backend can also be run with each instruction set of the
+ * scan kernels (see simd_scan.hh):
+ *
+ * ./bench_stl -n 10000000 -x scalar,avx2,avx512
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstdint>
+#include <unistd.h>
+#if _OPENMP
+#include <omp.h>
+#endif
+#include "interval_set.hh"
+#include "count_intersections.hh"
+#include "bsearch_count.hh"
+#include "workspace.hh"
+#include "phases.hh"
+#include "simd_scan.hh"
+#include "utils.hh"
+
+#ifndef BENCH_BACKEND
+#define BENCH_BACKEND "unknown"
+#endif
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+/* the mean length of the random intervals is (MIN_LEN + MAX_LEN)/2 */
+static const int MIN_LEN = 10;
+static const int MAX_LEN = 1000;
+
+struct config {
+    size_t n;           // number of intervals in A
+    size_t m;           // number of intervals in B
+    double density;     // mean number of intervals of B over each position
+    int threads;
+    simd_isa isa;       // instruction set of the scan kernels
+};
+
+/* median and variance of the `nreps` samples of a quantity */
+struct summary {
+    double median;
+    double variance;
+};
+
+void print_usage( const char *progname )
+{
+    cerr << "Usage: " << progname << " [-n sizes] [-m sizes] [-d densities] [-t threads] [-r nreps] [-e engine] [-x isas] [-f format] [-o outfile]" << endl << endl
+         << "Lists are comma-separated (e.g., -n 1000000,10000000)" << endl << endl
+         << "-n sizes\tnumber of intervals of A (default 1000000,10000000)" << endl
+         << "-m sizes\tnumber of intervals of B (default: same as A)" << endl
+         << "-d densities\tmean number of intervals of B over each position (default 1,10,100)" << endl
+         << "-t threads\tnumbers of threads (default 1,2,4,... up to the number of cores)" << endl
+         << "-r nreps\tmeasured runs of each configuration (default 11)" << endl
+         << "-e engine\tsweep (default) or bsearch" << endl
+         << "-x isas\t\tinstruction sets of the scan of the STL backend: scalar, avx2, avx512 (default: the best one)" << endl
+         << "-f format\tcsv (default) or json" << endl
+         << "-o outfile\twrite the results to outfile instead of the standard output" << endl
+         << "-h\t\tThis help message" << endl << endl;
+}
+
+/**
+ * Parse a comma-separated list of positive numbers; exit on error.
+ */
+template<typename T>
+std::vector<T> parse_list( const char *opt, const char *s )
+{
+    std::vector<T> result;
+    std::istringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        std::istringstream item_in(item);
+        T v;
+        if (!(item_in >> v) || !item_in.eof() || v <= 0) {
+            cerr << "FATAL: invalid value \"" << item << "\" for option -" << opt << endl;
+            exit(EXIT_FAILURE);
+        }
+        result.push_back(v);
+    }
+    if (result.empty()) {
+        cerr << "FATAL: empty list for option -" << opt << endl;
+        exit(EXIT_FAILURE);
+    }
+    return result;
+}
+
+/**
+ * Fill `v` with `n` random intervals whose left endpoints are
+ * uniformly distributed over [0, range). The generator is seeded by
+ * the caller, so that every backend sees the same input.
+ */
+void init( interval_set<int32_t> &v, size_t n, int32_t range, std::mt19937 &rng )
+{
+    std::uniform_int_distribution<int32_t> left_dist(0, range - 1);
+    std::uniform_int_distribution<int32_t> len_dist(MIN_LEN, MAX_LEN);
+    v.clear();
+    v.reserve(n);
+    for (size_t i=0; i<n; i++) {
+        const int32_t left = left_dist(rng);
+        v.push_back(left, left + len_dist(rng));
+    }
+}
+
+/**
+ * Parse a comma-separated list of instruction sets supported by the
+ * CPU; exit on error.
+ */
+std::vector<simd_isa> parse_isa_list( const char *s )
+{
+    std::vector<simd_isa> result;
+    std::istringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        simd_isa isa;
+        if (!parse_isa(item.c_str(), isa)) {
+            cerr << "FATAL: unknown instruction set \"" << item << "\"" << endl;
+            exit(EXIT_FAILURE);
+        }
+        if (!simd_set_isa(isa)) {
+            cerr << "FATAL: the CPU does not support " << item << endl;
+            exit(EXIT_FAILURE);
+        }
+        result.push_back(isa);
+    }
+    if (result.empty()) {
+        cerr << "FATAL: empty list for option -x" << endl;
+        exit(EXIT_FAILURE);
+    }
+    return result;
+}
+
+summary summarize( std::vector<double> samples )
+{
+    summary s;
+    const size_t n = samples.size();
+    std::sort(samples.begin(), samples.end());
+    s.median = (n % 2 ? samples[n/2] : (samples[n/2 - 1] + samples[n/2]) / 2);
+    double mean = 0.0;
+    for (size_t i=0; i<n; i++)
+        mean += samples[i];
+    mean /= n;
+    s.variance = 0.0;
+    for (size_t i=0; i<n; i++)
+        s.variance += (samples[i] - mean) * (samples[i] - mean);
+    s.variance = (n > 1 ? s.variance / (n - 1) : 0.0);
+    return s;
+}
+
+/**
+ * Run configuration `c` and store in `total` and `phases` the
+ * summaries of the total time and of the time of each phase.
+ */
+void run_config( const config &c, const std::string &engine, int nreps,
+                 summary &total, summary phases[N_PHASES] )
+{
+    // the coordinates must fit in 32 bits, which caps the range
+    const double max_range = INT32_MAX - MAX_LEN;
+    const int32_t range = std::max(1.0, std::min(max_range, c.m * ((MIN_LEN + MAX_LEN) / 2.0) / c.density));
+    std::mt19937 rng(1);
+    interval_set<int32_t> A, B;
+    init(A, c.n, range, rng);
+    init(B, c.m, range, rng);
+
+#if _OPENMP
+    omp_set_num_threads(c.threads);
+#endif
+    simd_set_isa(c.isa);
+    std::vector<int> counts;
+    std::vector<int> counts_bs;
+    count_workspace ws;
+    std::vector<double> t_total(nreps);
+    std::vector<double> t_phase[N_PHASES];
+    for (int p=0; p<N_PHASES; p++)
+        t_phase[p].resize(nreps);
+
+    // the kernels print a banner on each call
+    std::streambuf *cout_buf = cout.rdbuf(NULL);
+    phase_timer timer;
+    for (int r=-1; r<nreps; r++) { // r == -1 is the warm-up run
+        timer.reset();
+        phase_timer_set(&timer);
+        const double tstart = now();
+        if (engine == "bsearch")
+            count_intersections_bsearch(A, B, counts_bs);
+        else
+            count_intersections<int32_t, int>(A, B, counts, &ws);
+        const double elapsed = now() - tstart;
+        phase_timer_set(NULL);
+        if (r >= 0) {
+            t_total[r] = elapsed;
+            for (int p=0; p<N_PHASES; p++)
+                t_phase[p][r] = timer.elapsed[p];
+        }
+    }
+    cout.rdbuf(cout_buf);
+
+    total = summarize(t_total);
+    for (int p=0; p<N_PHASES; p++)
+        phases[p] = summarize(t_phase[p]);
+}
+
+void print_csv_header( std::ostream &out )
+{
+    out << "backend,engine,n,m,density,threads,isa,reps,total_median,total_variance";
+    for (int p=0; p<N_PHASES; p++)
+        out << "," << phase_names[p] << "_median," << phase_names[p] << "_variance";
+    out << endl;
+}
+
+void print_csv( std::ostream &out, const config &c, const std::string &engine, int nreps,
+                const summary &total, const summary phases[N_PHASES] )
+{
+    out << BENCH_BACKEND << "," << engine << "," << c.n << "," << c.m << ","
+        << c.density << "," << c.threads << "," << isa_names[c.isa] << "," << nreps << ","
+        << total.median << "," << total.variance;
+    for (int p=0; p<N_PHASES; p++)
+        out << "," << phases[p].median << "," << phases[p].variance;
+    out << endl;
+}
+
+void print_json( std::ostream &out, bool first, const config &c, const std::string &engine, int nreps,
+                 const summary &total, const summary phases[N_PHASES] )
+{
+    out << (first ? "[\n" : ",\n")
+        << "  {\"backend\": \"" << BENCH_BACKEND << "\", \"engine\": \"" << engine << "\", "
+        << "\"n\": " << c.n << ", \"m\": " << c.m << ", "
+        << "\"density\": " << c.density << ", \"threads\": " << c.threads << ", "
+        << "\"isa\": \"" << isa_names[c.isa] << "\", \"reps\": " << nreps << ",\n"
+        << "   \"total\": {\"median\": " << total.median << ", \"variance\": " << total.variance << "},\n"
+        << "   \"phases\": {";
+    for (int p=0; p<N_PHASES; p++) {
+        out << (p > 0 ? ", " : "") << "\"" << phase_names[p] << "\": {\"median\": "
+            << phases[p].median << ", \"variance\": " << phases[p].variance << "}";
+    }
+    out << "}}";
+}
+
+int main( int argc, char *argv[] )
+{
+    std::vector<size_t> sizes_A, sizes_B;
+    std::vector<double> densities;
+    std::vector<int> threads;
+    std::vector<simd_isa> isas;
+    int nreps = 11;
+    std::string engine("sweep");
+    std::string format("csv");
+    const char *outfile = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "hn:m:d:t:r:e:x:f:o:")) != -1) {
+        switch (opt) {
+        case 'n': // sizes of A
+            sizes_A = parse_list<size_t>("n", optarg);
+            break;
+        case 'm': // sizes of B
+            sizes_B = parse_list<size_t>("m", optarg);
+            break;
+        case 'd': // overlap densities
+            densities = parse_list<double>("d", optarg);
+            break;
+        case 't': // numbers of threads
+            threads = parse_list<int>("t", optarg);
+            break;
+        case 'r': // number of measured runs
+            nreps = atoi(optarg);
+            if (nreps < 1) {
+                cerr << "FATAL: the number of replications must be positive" << endl;
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'e': // counting engine
+            engine = optarg;
+            if (engine != "sweep" && engine != "bsearch") {
+                cerr << "FATAL: unknown engine \"" << engine << "\"" << endl;
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'x': // instruction sets
+            isas = parse_isa_list(optarg);
+            break;
+        case 'f': // output format
+            format = optarg;
+            if (format != "csv" && format != "json") {
+                cerr << "FATAL: unknown format \"" << format << "\"" << endl;
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'o': // output file name
+            outfile = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        default:
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (sizes_A.empty()) {
+        sizes_A.push_back(1000000);
+        sizes_A.push_back(10000000);
+    }
+    if (densities.empty()) {
+        densities.push_back(1);
+        densities.push_back(10);
+        densities.push_back(100);
+    }
+    if (threads.empty()) {
+#if _OPENMP
+        const int max_threads = omp_get_max_threads();
+#else
+        const int max_threads = 1;
+#endif
+        for (int p=1; p<max_threads; p *= 2)
+            threads.push_back(p);
+        threads.push_back(max_threads);
+    }
+    if (isas.empty()) {
+        isas.push_back(simd_best_isa());
+    }
+
+    std::ofstream fout;
+    if (outfile) {
+        fout.open(outfile);
+        if (!fout) {
+            cerr << "FATAL: can not create " << outfile << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    std::ostream &out = (outfile ? fout : cout);
+
+    if (format == "csv")
+        print_csv_header(out);
+    bool first = true;
+    for (size_t i=0; i<sizes_A.size(); i++) {
+        // without -m, A and B have the same size
+        const size_t m_begin = (sizes_B.empty() ? i : 0);
+        const size_t m_end = (sizes_B.empty() ? i+1 : sizes_B.size());
+        for (size_t j=m_begin; j<m_end; j++) {
+            for (size_t k=0; k<densities.size(); k++) {
+                for (size_t t=0; t<threads.size(); t++) {
+                    for (size_t x=0; x<isas.size(); x++) {
+                        config c;
+                        c.n = sizes_A[i];
+                        c.m = (sizes_B.empty() ? sizes_A[i] : sizes_B[j]);
+                        c.density = densities[k];
+                        c.threads = threads[t];
+                        c.isa = isas[x];
+                        cerr << BENCH_BACKEND << " " << engine << ": n=" << c.n << " m=" << c.m
+                             << " density=" << c.density << " threads=" << c.threads
+                             << " isa=" << isa_names[c.isa] << "... " << std::flush;
+                        summary total, phases[N_PHASES];
+                        run_config(c, engine, nreps, total, phases);
+                        cerr << total.median << " s" << endl;
+                        if (format == "csv")
+                            print_csv(out, c, engine, nreps, total, phases);
+                        else
+                            print_json(out, first, c, engine, nreps, total, phases);
+                        first = false;
+                    }
+                }
+            }
+        }
+    }
+    if (format == "json")
+        out << (first ? "[" : "") << "\n]" << endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ * bin_count.cc - count the intervals overlapping fixed-size bins
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <omp.h>
+#include "interval_set.hh"
+#include "bin_count.hh"
+
+size_t count_bins( const interval_set<int32_t> &B,
+                   int32_t width,
+                   std::vector<int> &counts )
+{
+    assert(width > 0);
+    const size_t m = B.size();
+
+    if (omp_get_level() == 0)
+        std::cout << "bin_count... " << std::flush;
+
+    /* Intervals with right < left (e.g., alignments without a
+       sequence) contain no base, and are ignored */
+    int32_t max_right = 0;
+#pragma omp parallel for reduction(max:max_right)
+    for (size_t i=0; i<m; i++) {
+        assert(B.left(i) >= 0);
+        max_right = std::max(max_right, B.right(i));
+    }
+    const size_t n_bins = std::max(counts.size(), size_t(max_right / width) + 1);
+    counts.resize(n_bins);
+
+    /* The interval [l, r] overlaps the bins l/width, ... r/width; it
+       records +1 at the first bin and -1 past the last bin in a
+       difference array shared by all threads (`counts` itself), and
+       the counts are its prefix sum. */
+    std::vector<int> blk_sum;
+    size_t total = 0;
+#pragma omp parallel reduction(+:total)
+    {
+        const int n_threads = omp_get_num_threads();
+        const int my_id = omp_get_thread_num();
+        const size_t my_start = n_bins * my_id / n_threads;
+        const size_t my_end = n_bins * (my_id + 1) / n_threads;
+
+#pragma omp single
+        blk_sum.resize(n_threads + 1);
+
+        std::fill(counts.begin() + my_start, counts.begin() + my_end, 0);
+#pragma omp barrier
+#pragma omp for
+        for (size_t i=0; i<m; i++) {
+            if (B.left(i) > B.right(i))
+                continue;
+            const size_t first = B.left(i) / width;
+            const size_t past = B.right(i) / width + 1;
+#pragma omp atomic
+            counts[first]++;
+            if (past < n_bins) {
+#pragma omp atomic
+                counts[past]--;
+            }
+        }
+
+        int cnt = 0;
+        for (size_t k=my_start; k<my_end; k++) {
+            cnt += counts[k];
+        }
+        blk_sum[my_id + 1] = cnt;
+#pragma omp barrier
+        cnt = 0;
+        for (int t=0; t<=my_id; t++) {
+            cnt += blk_sum[t];
+        }
+        for (size_t k=my_start; k<my_end; k++) {
+            cnt += counts[k];
+            counts[k] = cnt;
+            total += cnt;
+        }
+    }
+    return total;
+}
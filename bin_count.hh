@@ -0,0 +1,43 @@
+/****************************************************************************
+ *
+ * bin_count.hh - count the intervals overlapping fixed-size bins
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef BIN_COUNT_HH
+#define BIN_COUNT_HH
+
+#include <cstddef>
+#include <vector>
+#include "interval_set.hh"
+
+/**
+ * Count how many intervals in `B` overlap each bin of width `width`;
+ * bin k covers the coordinates k*width, ... (k+1)*width-1, and the
+ * first bin starts at coordinate 0. The bins are implicit: on exit,
+ * counts[k] is the count of bin k, where `counts` is enlarged (if
+ * needed) to include the bin of the largest right endpoint in B. The
+ * return value is the sum of all counts. The intervals in `B` must
+ * not have negative coordinates; empty intervals (right < left, as
+ * the alignments without a sequence) do not overlap any bin.
+ */
+size_t count_bins( const interval_set<int32_t> &B,
+                   int32_t width,
+                   std::vector<int> &counts );
+
+#endif /* BIN_COUNT_HH */
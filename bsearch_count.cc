@@ -0,0 +1,219 @@
+/****************************************************************************
+ *
+ * bsearch_count.cc - count intersections using binary search
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/* The number of intervals in B that overlap the closed interval [l,
+   r] is the number of left endpoints of B that are <= r, minus the
+   number of right endpoints of B that are < l. Therefore, it is
+   enough to sort the left and right endpoints of B separately; each
+   interval in A can then be handled independently with two binary
+   searches. If the intervals in A are sorted, the binary searches
+   are replaced by a merge-like scan of the sorted arrays. */
+
+#include <iostream>
+#include <vector>
+#include <omp.h>
+#include "interval_set.hh"
+#include "radix_sort.hh"
+#include "bsearch_count.hh"
+#include "phases.hh"
+#include "trace.hh"
+
+/**
+ * Return the number of elements of the sorted array a[0..n-1] that
+ * are <= x. The loop has no data-dependent branches, so the compiler
+ * turns the comparison into a conditional move.
+ */
+static size_t count_le( const int32_t *a, size_t n, int32_t x )
+{
+    if (n == 0)
+        return 0;
+    const int32_t *base = a;
+    while (n > 1) {
+        const size_t half = n / 2;
+        __builtin_prefetch(base + half/2);
+        __builtin_prefetch(base + half + half/2);
+        base = (base[half] <= x ? base + half : base);
+        n -= half;
+    }
+    return (base - a) + (*base <= x);
+}
+
+/**
+ * Return the number of elements of the sorted array a[0..n-1] that
+ * are < x.
+ */
+static size_t count_lt( const int32_t *a, size_t n, int32_t x )
+{
+    if (n == 0)
+        return 0;
+    const int32_t *base = a;
+    while (n > 1) {
+        const size_t half = n / 2;
+        __builtin_prefetch(base + half/2);
+        __builtin_prefetch(base + half + half/2);
+        base = (base[half] < x ? base + half : base);
+        n -= half;
+    }
+    return (base - a) + (*base < x);
+}
+
+/**
+ * Return true iff both the left and the right endpoints of the
+ * intervals in A are sorted in nondecreasing order.
+ */
+static bool endpoints_sorted( const interval_set<int32_t> &A )
+{
+    const size_t n = A.size();
+    const int32_t *l = A.left(), *r = A.right();
+    int unsorted = 0;
+#pragma omp parallel for reduction(|:unsorted)
+    for (size_t i=1; i<n; i++) {
+        unsorted |= (l[i-1] > l[i] || r[i-1] > r[i]);
+    }
+    return !unsorted;
+}
+
+template<typename Count>
+static size_t count_sorted_impl( const interval_set<int32_t> &A,
+                                 const int32_t *lefts,
+                                 const int32_t *rights,
+                                 size_t m,
+                                 std::vector<Count> &counts )
+{
+    const size_t n = A.size();
+    const int32_t *l = A.left(), *r = A.right();
+    size_t n_intersections = 0;
+
+    counts.resize(n);
+    if (endpoints_sorted(A)) {
+        /* Each thread handles a contiguous block of A: the initial
+           positions are computed with binary searches, then the
+           positions are moved forward as the endpoints of A
+           increase. */
+#pragma omp parallel reduction(+:n_intersections)
+        {
+            const int n_threads = omp_get_num_threads();
+            const int my_id = omp_get_thread_num();
+            const size_t my_start = n * my_id / n_threads;
+            const size_t my_end = n * (my_id + 1) / n_threads;
+
+            if (my_start < my_end) {
+                size_t nl = count_le(lefts, m, r[my_start]);
+                size_t nr = count_lt(rights, m, l[my_start]);
+                for (size_t i=my_start; i<my_end; i++) {
+                    while (nl < m && lefts[nl] <= r[i])
+                        nl++;
+                    while (nr < m && rights[nr] < l[i])
+                        nr++;
+                    counts[i] = nl - nr;
+                    n_intersections += counts[i];
+                }
+            }
+        }
+    } else {
+#pragma omp parallel for reduction(+:n_intersections)
+        for (size_t i=0; i<n; i++) {
+            counts[i] = count_le(lefts, m, r[i]) - count_lt(rights, m, l[i]);
+            n_intersections += counts[i];
+        }
+    }
+    return n_intersections;
+}
+
+size_t count_intersections_sorted( const interval_set<int32_t> &A,
+                                   const int32_t *lefts,
+                                   const int32_t *rights,
+                                   size_t m,
+                                   std::vector<int> &counts )
+{
+    return count_sorted_impl(A, lefts, rights, m, counts);
+}
+
+size_t count_intersections_sorted( const interval_set<int32_t> &A,
+                                   const int32_t *lefts,
+                                   const int32_t *rights,
+                                   size_t m,
+                                   std::vector<int64_t> &counts )
+{
+    return count_sorted_impl(A, lefts, rights, m, counts);
+}
+
+void sort_endpoints( const interval_set<int32_t> &B,
+                     std::vector<int32_t> &lefts,
+                     std::vector<int32_t> &rights )
+{
+    const size_t m = B.size();
+
+    /* The endpoints are sorted as unsigned integers, after flipping
+       the sign bit so that the unsigned order matches the signed
+       order of the coordinates. */
+    lefts.resize(m);
+    rights.resize(m);
+    uint32_t *ul = reinterpret_cast<uint32_t*>(lefts.data());
+    uint32_t *ur = reinterpret_cast<uint32_t*>(rights.data());
+    std::vector<uint32_t> tmp(m);
+    const int32_t *l = B.left(), *r = B.right();
+#pragma omp parallel for
+    for (size_t i=0; i<m; i++) {
+        ul[i] = uint32_t(l[i]) ^ 0x80000000u;
+        ur[i] = uint32_t(r[i]) ^ 0x80000000u;
+    }
+    radix_sort(ul, tmp.data(), m);
+    radix_sort(ur, tmp.data(), m);
+#pragma omp parallel for
+    for (size_t i=0; i<m; i++) {
+        ul[i] ^= 0x80000000u;
+        ur[i] ^= 0x80000000u;
+    }
+}
+
+template<typename Count>
+static size_t count_bsearch_impl( const interval_set<int32_t> &A,
+                                  const interval_set<int32_t> &B,
+                                  std::vector<Count> &counts )
+{
+    if (omp_get_level() == 0)
+        std::cout << "bsearch_count... " << std::flush;
+
+    phase_start();
+    std::vector<int32_t> lefts, rights;
+    sort_endpoints(B, lefts, rights);
+    TRACE_BYTES(4*B.size()*sizeof(int32_t));
+    phase_end(PHASE_SORT);
+    const size_t n_intersections = count_intersections_sorted(A, lefts.data(), rights.data(), B.size(), counts);
+    TRACE_BYTES(A.size()*(2*sizeof(int32_t) + sizeof(Count)));
+    phase_end(PHASE_SCAN);
+    return n_intersections;
+}
+
+size_t count_intersections_bsearch( const interval_set<int32_t> &A,
+                                    const interval_set<int32_t> &B,
+                                    std::vector<int> &counts )
+{
+    return count_bsearch_impl(A, B, counts);
+}
+
+size_t count_intersections_bsearch( const interval_set<int32_t> &A,
+                                    const interval_set<int32_t> &B,
+                                    std::vector<int64_t> &counts )
+{
+    return count_bsearch_impl(A, B, counts);
+}
@@ -0,0 +1,69 @@
+/****************************************************************************
+ *
+ * bsearch_count.hh - count intersections using binary search
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef BSEARCH_COUNT_HH
+#define BSEARCH_COUNT_HH
+
+#include <vector>
+#include <cstdint>
+#include "interval_set.hh"
+
+/**
+ * Count how many intervals in `B` overlap each interval in `A`.
+ * The result is stored in the array `counts`; the return value is
+ * the total number of intersections. Same as count_intersections(),
+ * but only the endpoints of `B` are sorted; this is faster when `A`
+ * is much smaller than `B`. The counts of intervals of A that may
+ * overlap 2^31 or more intervals of B (see needs_64bit_counts()) must
+ * be 64 bits wide.
+ */
+size_t count_intersections_bsearch( const interval_set<int32_t> &A,
+                                    const interval_set<int32_t> &B,
+                                    std::vector<int> &counts );
+size_t count_intersections_bsearch( const interval_set<int32_t> &A,
+                                    const interval_set<int32_t> &B,
+                                    std::vector<int64_t> &counts );
+
+/**
+ * Store in `lefts` and `rights` the left and right endpoints of the
+ * intervals in `B`, each sorted in nondecreasing order.
+ */
+void sort_endpoints( const interval_set<int32_t> &B,
+                     std::vector<int32_t> &lefts,
+                     std::vector<int32_t> &rights );
+
+/**
+ * Same as count_intersections_bsearch(), where `lefts` and `rights`
+ * are the `m` left endpoints and the `m` right endpoints of `B`,
+ * each sorted in nondecreasing order.
+ */
+size_t count_intersections_sorted( const interval_set<int32_t> &A,
+                                   const int32_t *lefts,
+                                   const int32_t *rights,
+                                   size_t m,
+                                   std::vector<int> &counts );
+size_t count_intersections_sorted( const interval_set<int32_t> &A,
+                                   const int32_t *lefts,
+                                   const int32_t *rights,
+                                   size_t m,
+                                   std::vector<int64_t> &counts );
+
+#endif /* BSEARCH_COUNT_HH */
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ * check_enumerate.cc - check the pairs of enumerate_intersections()
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/* Compare the pairs produced by enumerate_intersections() with the
+   pairs found by brute force, on inputs where some intervals of B are
+   empty (as the alignments with no bases, [pos+1, pos]) and start at
+   the left endpoint of an interval of A. Two intervals [a, b] and
+   [c, d] overlap iff c <= b and d >= a, as in the sweep. */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstdint>
+#include "interval_set.hh"
+#include "enumerate.hh"
+
+static bool operator<( const overlap &x, const overlap &y )
+{
+    return x.a < y.a || (x.a == y.a && x.b < y.b);
+}
+
+static bool operator==( const overlap &x, const overlap &y )
+{
+    return x.a == y.a && x.b == y.b;
+}
+
+/* Return true iff the pairs of A and B are correct */
+static bool check( const char *name,
+                   const std::vector<int32_t> &lA, const std::vector<int32_t> &rA,
+                   const std::vector<int32_t> &lB, const std::vector<int32_t> &rB,
+                   size_t batch_size )
+{
+    const interval_set<int32_t> A(lA.data(), rA.data(), lA.size());
+    const interval_set<int32_t> B(lB.data(), rB.data(), lB.size());
+
+    std::vector<overlap> expected;
+    for (size_t i=0; i<lA.size(); i++) {
+        for (size_t j=0; j<lB.size(); j++) {
+            if (lB[j] <= rA[i] && rB[j] >= lA[i])
+                expected.push_back(overlap{i, j});
+        }
+    }
+
+    std::vector<overlap> pairs;
+    const size_t n_pairs = enumerate_intersections(A, B,
+                                                   [&pairs]( const overlap *p, size_t n ) {
+                                                       pairs.insert(pairs.end(), p, p + n);
+                                                   },
+                                                   batch_size);
+    std::sort(pairs.begin(), pairs.end());
+    const bool ok = (n_pairs == expected.size() && pairs == expected);
+    std::cout << name << ": " << n_pairs << " pairs (expected " << expected.size() << ") "
+              << (ok ? "OK" : "FAILED") << std::endl;
+    return ok;
+}
+
+int main( void )
+{
+    bool ok = true;
+
+    /* An empty interval of B at the left endpoint of the interval of A */
+    ok &= check("empty at left", {10}, {20}, {10, 12}, {9, 15}, PAIR_BATCH_SIZE);
+
+    /* Random intervals, with one empty interval of B at the left
+       endpoint of each interval of A, and some empty intervals at
+       random positions; small batches */
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int32_t> pos(0, 10000), len(0, 200);
+    std::vector<int32_t> lA, rA, lB, rB;
+    for (int i=0; i<500; i++) {
+        const int32_t l = pos(rng);
+        lA.push_back(l);
+        rA.push_back(l + len(rng));
+        lB.push_back(l);
+        rB.push_back(l - 1);
+    }
+    for (int j=0; j<2000; j++) {
+        const int32_t l = pos(rng);
+        lB.push_back(l);
+        rB.push_back(j % 7 == 0 ? l - 1 : l + len(rng));
+    }
+    ok &= check("random", lA, rA, lB, rB, 1000);
+
+    std::cout << (ok ? "check OK" : "check FAILED") << std::endl;
+    return (ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,52 @@
+/****************************************************************************
+ *
+ * count_intersections.cc - count intersections of arrays of intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <vector>
+#include <climits>
+#include "interval.hh"
+#include "interval_set.hh"
+#include "endpoint.hh"
+#include "count_intersections.hh"
+
+/* The intervals are copied into separate arrays of coordinates, that
+   are used by the counting kernels of all backends */
+size_t count_intersections( const std::vector<interval> &A,
+                            const std::vector<interval> &B,
+                            std::vector<int> &counts,
+                            count_workspace *ws )
+{
+    std::vector<int> c;
+    const size_t n_intersections = count_intersections(interval_set<int32_t>(A),
+                                                       interval_set<int32_t>(B),
+                                                       c, ws);
+    counts.assign(A.size(), 0);
+    for (size_t i=0; i<A.size(); i++) {
+        counts[A[i].id] += c[i];
+    }
+    return n_intersections;
+}
+
+bool needs_64bit_counts( size_t n, size_t m )
+{
+    return (n >= endpoint::MAX_INTERVALS ||
+            m >= endpoint::MAX_INTERVALS ||
+            2*(n+m) > size_t(INT_MAX));
+}
@@ -24,13 +24,55 @@
 
 #include <vector>
 #include "interval.hh"
+#include "interval_set.hh"
+#include "workspace.hh"
 
 /**
  * Count how many intervals in `upd` overlap each interval in `sub`.
- * The result is stored in the array `counts`.
+ * The result is stored in the array `counts`, where counts[i] refers
+ * to the interval with ID i. The temporary arrays are taken from
+ * `ws`, if not NULL; otherwise, they are allocated and released on
+ * each call.
  */
 size_t count_intersections( const std::vector<interval> &sub,
                             const std::vector<interval> &upd,
-                            std::vector<int> &counts );
+                            std::vector<int> &counts,
+                            count_workspace *ws = NULL );
+
+/**
+ * Same as above, where the intervals are stored as separate arrays
+ * of left and right endpoints, and the ID of an interval is its
+ * position in the set. `Coord` is the type of the coordinates
+ * (int32_t or int64_t), `Count` the type of the counts (int or
+ * int64_t); the return value is the total number of intersections.
+ */
+template<typename Coord, typename Count>
+size_t count_intersections( const interval_set<Coord> &sub,
+                            const interval_set<Coord> &upd,
+                            std::vector<Count> &counts,
+                            count_workspace *ws = NULL );
+
+/**
+ * Same as above, where `counts_B` is also filled with the number of
+ * intervals in `sub` that overlap each interval in `upd`. Both
+ * directions are computed from a single sort of the endpoints, with
+ * a single scan.
+ */
+template<typename Coord, typename Count>
+size_t count_intersections_symmetric( const interval_set<Coord> &sub,
+                                      const interval_set<Coord> &upd,
+                                      std::vector<Count> &counts_A,
+                                      std::vector<Count> &counts_B,
+                                      count_workspace *ws = NULL );
+
+/**
+ * Return true iff counting the intersections between `n` and `m`
+ * intervals requires 64-bit IDs and counts, i.e., the template
+ * version of count_intersections() must be used with Count ==
+ * int64_t. With 32-bit counts, each set can have up to 2^30 - 1
+ * intervals, and there can be at most 2^31 - 1 endpoints overall.
+ * The total number of intersections is always computed in 64 bits.
+ */
+bool needs_64bit_counts( size_t n, size_t m );
 
 #endif /* COUNT_INTERSECTIONS_HH */
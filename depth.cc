@@ -0,0 +1,98 @@
+/****************************************************************************
+ *
+ * depth.cc - per-base depth of coverage over target intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+#include "interval_set.hh"
+#include "bsearch_count.hh"
+#include "depth.hh"
+
+size_t depth_of_coverage_sorted( const interval_set<int32_t> &A,
+                                 const int32_t *lefts,
+                                 const int32_t *rights,
+                                 size_t m,
+                                 std::vector<size_t> &offsets,
+                                 std::vector<int> &depth )
+{
+    const size_t n = A.size();
+
+    offsets.resize(n + 1);
+    offsets[0] = 0;
+    for (size_t i=0; i<n; i++) {
+        const int32_t len = (A.right(i) > A.left(i) ? A.right(i) - A.left(i) : 0);
+        offsets[i+1] = offsets[i] + len;
+    }
+    depth.resize(offsets[n]);
+
+    /* The depth of base p is the number of left endpoints of B that
+       are <= p, minus the number of right endpoints of B that are
+       < p. Therefore, the depth of the first base of a target is
+       computed with two binary searches; moving from base p-1 to
+       base p, the depth increases by the number of left endpoints
+       equal to p, and decreases by the number of right endpoints
+       equal to p-1. The differences are accumulated in the depth
+       array, that is then turned into the depths by a prefix sum.
+       Each target only touches the endpoints of B that fall inside
+       it, so the targets are processed in parallel. */
+    size_t total = 0;
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:total)
+    for (size_t i=0; i<n; i++) {
+        const size_t len = offsets[i+1] - offsets[i];
+        if (len == 0)
+            continue;
+        const int32_t L = A.left(i);
+        const int32_t R = A.right(i);
+        int *d = depth.data() + offsets[i];
+        std::fill(d, d + len, 0);
+
+        size_t il = std::upper_bound(lefts, lefts + m, L) - lefts;
+        size_t ir = std::lower_bound(rights, rights + m, L) - rights;
+        d[0] = int(il) - int(ir);
+        for (; il < m && lefts[il] < R; il++) {
+            d[lefts[il] - L]++;
+        }
+        for (; ir < m && rights[ir] < R - 1; ir++) {
+            d[rights[ir] - L + 1]--;
+        }
+        size_t sum = d[0];
+        for (size_t p=1; p<len; p++) {
+            d[p] += d[p-1];
+            sum += d[p];
+        }
+        total += sum;
+    }
+    return total;
+}
+
+size_t depth_of_coverage( const interval_set<int32_t> &A,
+                          const interval_set<int32_t> &B,
+                          std::vector<size_t> &offsets,
+                          std::vector<int> &depth )
+{
+    if (omp_get_level() == 0)
+        std::cout << "depth... " << std::flush;
+
+    std::vector<int32_t> lefts, rights;
+    sort_endpoints(B, lefts, rights);
+    return depth_of_coverage_sorted(A, lefts.data(), rights.data(), B.size(), offsets, depth);
+}
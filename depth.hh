@@ -0,0 +1,60 @@
+/****************************************************************************
+ *
+ * depth.hh - per-base depth of coverage over target intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef DEPTH_HH
+#define DEPTH_HH
+
+#include <cstddef>
+#include <vector>
+#include "interval_set.hh"
+
+/**
+ * Compute the depth of coverage of each base of the target intervals
+ * in `A`, i.e., the number of intervals in `B` that contain it. The
+ * bases of the target [left, right] are left, left+1, ... right-1.
+ * This differs from the count over the closed 1-base windows
+ * [p, p+1] used by the former windowing code: an interval of `B`
+ * that starts at p+1 overlaps the window [p, p+1], but does not
+ * contribute to the depth of base p.
+ *
+ * The depths are stored contiguously in `depth`: the depths of the
+ * bases of A[i] are depth[offsets[i]], ... depth[offsets[i+1]-1],
+ * where `offsets` has A.size()+1 elements. The return value is the
+ * sum of all depths.
+ */
+size_t depth_of_coverage( const interval_set<int32_t> &A,
+                          const interval_set<int32_t> &B,
+                          std::vector<size_t> &offsets,
+                          std::vector<int> &depth );
+
+/**
+ * Same as depth_of_coverage(), where `lefts` and `rights` are the `m`
+ * left endpoints and the `m` right endpoints of `B`, each sorted in
+ * nondecreasing order.
+ */
+size_t depth_of_coverage_sorted( const interval_set<int32_t> &A,
+                                 const int32_t *lefts,
+                                 const int32_t *rights,
+                                 size_t m,
+                                 std::vector<size_t> &offsets,
+                                 std::vector<int> &depth );
+
+#endif /* DEPTH_HH */
@@ -22,7 +22,8 @@
 #ifndef ENDPOINT_HH
 #define ENDPOINT_HH
 
-#include <cassert>
+#include <cstdint>
+#include <type_traits>
 
 #if __CUDACC__
 #define GLOBAL __host__ __device__
@@ -33,49 +34,182 @@
 /******************************************************************************
  * Endpoint stored in the endpoint arrays. Each endpoint represents a
  * single scalar value v, that can either correspond to a lower or
- * upper bound of a subscription or update region.
+ * upper bound of an interval in set A or set B.
+ *
+ * Endpoints are packed into a single unsigned integer of type Key (a
+ * "key"), where v has type Coord. With 32-bit coordinates and 64-bit
+ * keys the layout is as follows:
+ *
+ *  63           32   31   30  29          0
+ * +---------------+----+----+--------------+
+ * | v ^ 0x80000000|  e |  t |      id      |
+ * +---------------+----+----+--------------+
+ *
+ * With 128-bit keys, the id takes 62 bits and v takes the next 32
+ * or 64 bits (for 32-bit or 64-bit coordinates); the remaining upper
+ * bits, if any, are zero. In general, the id takes all bits not used
+ * by v, e and t, up to 62 bits.
+ *
+ * The sign bit of v is flipped so that the unsigned order of the
+ * upper bits matches the signed order of v. Since we are dealing
+ * with closed intervals, a lower endpoint must always precede an
+ * upper endpoint with the same value, otherwise an overlap is
+ * missed; this is ensured by LEFT < RIGHT. Therefore, the natural
+ * order of the keys is the order in which endpoints must be sorted,
+ * and comparing two endpoints requires a single integer comparison.
  ******************************************************************************/
-struct endpoint {
-    enum ep_extreme { LEFT, RIGHT, UNDEF };
-    enum ep_type { SET_A, SET_B };
+struct endpoint_base {
+    enum ep_extreme { LEFT = 0, RIGHT = 1 };
+    enum ep_type { SET_A = 0, SET_B = 1 };
+};
+
+template<typename Key, typename Coord>
+struct basic_endpoint : public endpoint_base {
+    typedef Key key;
+    typedef Coord coord;
+    // unsigned type with the same width as Coord
+    typedef typename std::make_unsigned<Coord>::type ucoord;
+    // type of interval IDs and of the counts of endpoints
+    typedef typename std::conditional<(sizeof(Key) > 8), int64_t, int>::type index;
 
-    int id;     // ID of the interval this endpoint belongs to
-    int32_t v;  // value of this endpoint
-    ep_extreme e; // whether this is a lower or upper endpoint
-    ep_type t;  // whether this endpoint belongs to a subscription or update interval
+    static const int COORD_BITS = 8*sizeof(Coord);
+    // Number of bits reserved to the interval ID
+    static const int ID_BITS = (8*sizeof(Key) - COORD_BITS - 2 > 62 ? 62 : 8*sizeof(Key) - COORD_BITS - 2);
+    // Maximum number of intervals in each set
+    static const uint64_t MAX_INTERVALS = (uint64_t(1) << ID_BITS);
+    // Bits below this position do not affect the endpoint order
+    static const int ORDER_BIT = ID_BITS + 1;
+
+    static_assert(ID_BITS > 0 && ID_BITS < 64, "Key too small for Coord");
 
-    // Default constructor
     GLOBAL
-    endpoint() :
-        id(0), v(0), e(UNDEF), t(SET_A)
-    { };
+    static key make(index id, coord v, ep_extreme e, ep_type t)
+    {
+        return (key(ucoord(v) ^ SIGN) << (ID_BITS + 2)) |
+            (key(e) << (ID_BITS + 1)) |
+            (key(t) << ID_BITS) |
+            (key(id) & key(MAX_INTERVALS - 1));
+    }
 
-    // Constructor
+    // value of endpoint k
     GLOBAL
-    endpoint(int ep_id, int32_t ep_v, ep_extreme ep_e, ep_type ep_t) :
-        id( ep_id ), v( ep_v ), e( ep_e ), t( ep_t )
-    { };
+    static coord value(key k)
+    {
+        return coord(ucoord(k >> (ID_BITS + 2)) ^ SIGN);
+    }
 
-    // Copy constructor
+    // whether k is a lower or upper endpoint
     GLOBAL
-    endpoint(const endpoint& other) :
-        id( other.id ), v( other.v ), e( other.e ), t( other.t )
-    { };
+    static ep_extreme extreme(key k)
+    {
+        return ep_extreme(int(k >> (ID_BITS + 1)) & 1);
+    }
 
-    /* Endpoints are sorted according to their value. Special care
-       must be taken for endpoints having exactly the same value.
-       Since we are dealing with closed intervals, a lower
-       endpoint must always precede an upper endpoint with the
-       same value. If this does not happen, an overlap is missed.
-    */
+    // whether k belongs to an interval in set A or set B
+    GLOBAL
+    static ep_type type(key k)
+    {
+        return ep_type(int(k >> ID_BITS) & 1);
+    }
+
+    // ID of the interval k belongs to
+    GLOBAL
+    static index id(key k)
+    {
+        return index(k & key(MAX_INTERVALS - 1));
+    }
+
+    // 1 iff k is the lower endpoint of an interval in B
+    GLOBAL
+    static int is_left_B(key k)
+    {
+        return (int(k >> ID_BITS) & 3) == ((LEFT << 1) | SET_B);
+    }
 
+    // 1 iff k is the upper endpoint of an interval in B
     GLOBAL
-    bool operator < (const endpoint& other) const
+    static int is_right_B(key k)
     {
-        assert( UNDEF != e );
-        assert( UNDEF != other.e );
-        return (v < other.v || (v == other.v && e == LEFT && other.e == RIGHT));
+        return (int(k >> ID_BITS) & 3) == ((RIGHT << 1) | SET_B);
     }
+
+    // 1 iff k is the lower endpoint of an interval in A
+    GLOBAL
+    static int is_left_A(key k)
+    {
+        return (int(k >> ID_BITS) & 3) == ((LEFT << 1) | SET_A);
+    }
+
+    // 1 iff k is the upper endpoint of an interval in A
+    GLOBAL
+    static int is_right_A(key k)
+    {
+        return (int(k >> ID_BITS) & 3) == ((RIGHT << 1) | SET_A);
+    }
+
+    /* The number of left and right endpoints of B seen so far during
+       a scan of the sorted endpoints are packed into a single counter
+       of the same type as the keys: the number of left endpoints goes
+       in the lower half, the number of right endpoints in the upper
+       half. Both are updated with a single addition. The endpoints of
+       A can be counted in the same way (count_A()). */
+    typedef Key counter;
+    static const int HALF_BITS = 4*sizeof(Key);
+
+    // contribution of endpoint k to the counter
+    GLOBAL
+    static counter count_B(key k)
+    {
+        return counter(is_left_B(k)) | (counter(is_right_B(k)) << HALF_BITS);
+    }
+
+    // contribution of endpoint k to the counter of the endpoints of A
+    GLOBAL
+    static counter count_A(key k)
+    {
+        return counter(is_left_A(k)) | (counter(is_right_A(k)) << HALF_BITS);
+    }
+
+    // number of left endpoints in counter c
+    GLOBAL
+    static index nleft(counter c)
+    {
+        return index(c & ((counter(1) << HALF_BITS) - 1));
+    }
+
+    // number of right endpoints in counter c
+    GLOBAL
+    static index nright(counter c)
+    {
+        return index(c >> HALF_BITS);
+    }
+
+private:
+    static const ucoord SIGN = ucoord(1) << (COORD_BITS - 1);
 };
 
+// Endpoints of intervals with 32-bit coordinates
+typedef basic_endpoint<uint64_t, int32_t> endpoint;
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 uint128_t;
+
+// Endpoints of intervals with 32-bit coordinates and 62-bit IDs
+typedef basic_endpoint<uint128_t, int32_t> endpoint_wide;
+
+// Endpoints of intervals with 64-bit coordinates
+typedef basic_endpoint<uint128_t, int64_t> endpoint64;
+#endif
+
+/* endpoint_for<Coord, Count>::type is the endpoint type for intervals
+   with coordinates of type Coord, when the counts have type Count:
+   64-bit counts imply 64-bit IDs, hence 128-bit keys */
+template<typename Coord, typename Count> struct endpoint_for;
+template<> struct endpoint_for<int32_t, int> { typedef endpoint type; };
+#ifdef __SIZEOF_INT128__
+template<> struct endpoint_for<int32_t, int64_t> { typedef endpoint_wide type; };
+template<> struct endpoint_for<int64_t, int> { typedef endpoint64 type; };
+template<> struct endpoint_for<int64_t, int64_t> { typedef endpoint64 type; };
+#endif
+
 #endif
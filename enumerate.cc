@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ * enumerate.cc - enumerate the pairs of overlapping intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+/* The intervals of B that overlap an interval [l, r] of A are those
+   whose left endpoint is in [l, r], plus those that start before l
+   and end at or after l. If B is sorted by left endpoint, the former
+   are a contiguous range that is found with two binary searches
+   (an empty interval [l, l-1] of B falls in the range, but does not
+   overlap, as in the sweep, and is skipped);
+   the latter are found in a tree of the maximum right endpoint of
+   each range of B, skipping the subtrees whose intervals all end
+   before l. Each of them costs O(log m), so that a few long
+   intervals of B near the beginning of the contig do not cause a
+   scan of all the intervals that precede l. */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#include <omp.h>
+#include "interval_set.hh"
+#include "count_intersections.hh"
+#include "radix_sort.hh"
+#include "workspace.hh"
+#include "enumerate.hh"
+
+/* Slots of the workspace used by enumerate_intersections(); they
+   follow those of the counting kernels, so that the same workspace
+   can be passed to count_intersections() */
+enum {
+    WS_KEYS = 16,
+    WS_TMP,
+    WS_LEFT,
+    WS_RIGHT,
+    WS_ID,
+    WS_MAX_RIGHT,
+    WS_PAIRS
+};
+
+/* Count the intersections of each interval of A, and store in
+   offsets[i] the total number of intersections of the intervals of A
+   before i, for i = 0, ... n */
+template<typename Count>
+static void count_offsets( const interval_set<int32_t> &A,
+                           const interval_set<int32_t> &B,
+                           std::vector<size_t> &offsets,
+                           count_workspace *ws )
+{
+    std::vector<Count> counts;
+    count_intersections(A, B, counts, ws);
+    offsets.resize(A.size() + 1);
+    offsets[0] = 0;
+    for (size_t i=0; i<A.size(); i++) {
+        offsets[i+1] = offsets[i] + counts[i];
+    }
+}
+
+/* Store in out[0], out[1], ... the pairs (a, ids[j]) for each j <
+   lo, in increasing order, such that rights[j] >= x; `max_right` is
+   the tree of the maximum right endpoints, where node v covers the
+   intervals v_lo, ... v_hi-1. Return the end of the output. */
+static overlap *collect_before( const int32_t *max_right, size_t v, size_t v_lo, size_t v_hi,
+                                size_t lo, int32_t x, size_t a,
+                                const uint32_t *ids, overlap *out )
+{
+    if (v_lo >= lo || max_right[v] < x)
+        return out;
+    if (v_hi - v_lo == 1) {
+        out->a = a;
+        out->b = ids[v_lo];
+        return out + 1;
+    }
+    const size_t mid = v_lo + (v_hi - v_lo) / 2;
+    out = collect_before(max_right, 2*v, v_lo, mid, lo, x, a, ids, out);
+    return collect_before(max_right, 2*v + 1, mid, v_hi, lo, x, a, ids, out);
+}
+
+size_t enumerate_intersections( const interval_set<int32_t> &A,
+                                const interval_set<int32_t> &B,
+                                const overlap_sink &emit,
+                                size_t batch_size,
+                                count_workspace *ws )
+{
+    const size_t n = A.size();
+    const size_t m = B.size();
+    assert(m < (size_t(1) << 32));
+    assert(batch_size > 0);
+
+    count_workspace local_ws;
+    if (ws == NULL)
+        ws = &local_ws;
+
+    if (omp_get_level() == 0)
+        std::cout << "enumerate... " << std::flush;
+
+    std::vector<size_t> offsets;
+    if (needs_64bit_counts(n, m))
+        count_offsets<int64_t>(A, B, offsets, ws);
+    else
+        count_offsets<int>(A, B, offsets, ws);
+    const size_t n_pairs = offsets[n];
+    if (n_pairs == 0)
+        return 0;
+
+    /* Sort B by left endpoint: each key holds the left endpoint (with
+       the sign bit flipped) in the upper 32 bits and the index of the
+       interval in the lower 32 bits, which are skipped by the (stable)
+       radix sort. */
+    uint64_t *keys = ws->get<uint64_t>(WS_KEYS, m);
+    const int32_t *lB = B.left(), *rB = B.right();
+#pragma omp parallel for
+    for (size_t j=0; j<m; j++) {
+        keys[j] = (uint64_t(uint32_t(lB[j]) ^ 0x80000000u) << 32) | j;
+    }
+    radix_sort(keys, ws->get<uint64_t>(WS_TMP, m), m, 32);
+    int32_t *lefts = ws->get<int32_t>(WS_LEFT, m);
+    int32_t *rights = ws->get<int32_t>(WS_RIGHT, m);
+    uint32_t *ids = ws->get<uint32_t>(WS_ID, m);
+#pragma omp parallel for
+    for (size_t j=0; j<m; j++) {
+        ids[j] = uint32_t(keys[j]);
+        lefts[j] = lB[ids[j]];
+        rights[j] = rB[ids[j]];
+    }
+
+    /* Tree of the maximum right endpoints: the leaves n_leaves, ...
+       n_leaves+m-1 are the right endpoints of the sorted intervals,
+       and node v is the maximum of nodes 2v and 2v+1 */
+    size_t n_leaves = 1;
+    while (n_leaves < m)
+        n_leaves *= 2;
+    int32_t *max_right = ws->get<int32_t>(WS_MAX_RIGHT, 2*n_leaves);
+#pragma omp parallel for
+    for (size_t j=0; j<n_leaves; j++) {
+        max_right[n_leaves + j] = (j < m ? rights[j] : INT32_MIN);
+    }
+    for (size_t level=n_leaves/2; level>0; level/=2) {
+#pragma omp parallel for
+        for (size_t v=level; v<2*level; v++) {
+            max_right[v] = std::max(max_right[2*v], max_right[2*v + 1]);
+        }
+    }
+
+    /* The largest batch holds either `batch_size` pairs, or the pairs
+       of a single interval of A */
+    size_t max_batch = std::min(batch_size, n_pairs);
+    for (size_t i=0; i<n; i++) {
+        max_batch = std::max(max_batch, offsets[i+1] - offsets[i]);
+    }
+    overlap *pairs = ws->get<overlap>(WS_PAIRS, max_batch);
+
+    const int32_t *lA = A.left(), *rA = A.right();
+    size_t first = 0;
+    while (first < n) {
+        /* The batch holds the pairs of the intervals first, ... last-1 */
+        size_t last = first + 1;
+        while (last < n && offsets[last+1] - offsets[first] <= batch_size)
+            last++;
+        const size_t base = offsets[first];
+
+#pragma omp parallel for schedule(dynamic, 64)
+        for (size_t i=first; i<last; i++) {
+            const size_t cnt = offsets[i+1] - offsets[i];
+            if (cnt == 0)
+                continue;
+            overlap *out = pairs + (offsets[i] - base);
+            const size_t lo = std::lower_bound(lefts, lefts + m, lA[i]) - lefts;
+            const size_t hi = std::upper_bound(lefts + lo, lefts + m, rA[i]) - lefts;
+            out = collect_before(max_right, 1, 0, n_leaves, lo, lA[i], i, ids, out);
+            for (size_t j=lo; j<hi; j++) {
+                if (rights[j] < lA[i])
+                    continue;
+                out->a = i;
+                out->b = ids[j];
+                out++;
+            }
+            assert(out == pairs + (offsets[i+1] - base));
+        }
+        emit(pairs, offsets[last] - base);
+        first = last;
+    }
+    return n_pairs;
+}
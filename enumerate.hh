@@ -0,0 +1,69 @@
+/****************************************************************************
+ *
+ * enumerate.hh - enumerate the pairs of overlapping intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef ENUMERATE_HH
+#define ENUMERATE_HH
+
+#include <cstddef>
+#include <functional>
+#include "interval_set.hh"
+#include "workspace.hh"
+
+/**
+ * A pair of overlapping intervals: `a` is the index of the interval
+ * in A, and `b` is the index of the interval in B.
+ */
+struct overlap {
+    size_t a;
+    size_t b;
+};
+
+/**
+ * Receives `n` pairs of overlapping intervals at a time.
+ */
+typedef std::function<void(const overlap *pairs, size_t n)> overlap_sink;
+
+/* Default maximum number of pairs that are produced at a time (64 MB) */
+const size_t PAIR_BATCH_SIZE = 1 << 22;
+
+/**
+ * Enumerate all pairs of overlapping intervals of A and B, like
+ * `bedtools intersect -wa -wb`, and pass them to `emit` in batches of
+ * (at most) `batch_size` pairs; a batch may be larger only if a
+ * single interval of A overlaps more than `batch_size` intervals of
+ * B. The pairs are sorted by interval of A, then by left endpoint of
+ * the interval of B. `emit` is always called by the calling thread.
+ * Return the number of pairs.
+ *
+ * The number of intersections of each interval of A is computed
+ * first with count_intersections(); their prefix sums give the
+ * position of the pairs of each interval in the output batch, which
+ * is then filled in parallel. The temporary arrays are taken from
+ * `ws`, if not NULL. B can have at most 2^32 - 1 intervals.
+ */
+size_t enumerate_intersections( const interval_set<int32_t> &A,
+                                const interval_set<int32_t> &B,
+                                const overlap_sink &emit,
+                                size_t batch_size = PAIR_BATCH_SIZE,
+                                count_workspace *ws = NULL );
+
+#endif /* ENUMERATE_HH */
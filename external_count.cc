@@ -0,0 +1,322 @@
+/****************************************************************************
+ *
+ * external_count.cc - out-of-core counting of intersections
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "interval_set.hh"
+#include "workspace.hh"
+#include "count_intersections.hh"
+#include "external_count.hh"
+
+/* Size of the I/O buffers of the input spill files, and number of
+   records read at a time */
+static const size_t SPILL_BUFSIZE = 8 << 20;
+static const size_t CHUNK_SIZE = 1 << 18;
+/* Size of the I/O buffer of each slab file */
+static const size_t SLAB_BUFSIZE_MIN = 64 << 10;
+static const size_t SLAB_BUFSIZE_MAX = 4 << 20;
+/* Resolution of the histogram of left endpoints used to choose the
+   slab boundaries */
+static const size_t N_BUCKETS = 1 << 16;
+/* Maximum number of slab files that are open at the same time; if
+   there are more slabs, the spill files are scanned more than once */
+static const size_t MAX_OPEN_SLABS = 128;
+
+/* Create a temporary file in directory `dir`, open it for reading and
+   writing with a buffer `buf` of `bufsize` bytes, and unlink it, so
+   that it is removed as soon as it is closed. Return NULL on
+   error. */
+static FILE *create_spill( const std::string &dir, std::vector<char> &buf, size_t bufsize )
+{
+    std::string tmpl = dir + "/intersections-XXXXXX";
+    std::vector<char> name(tmpl.begin(), tmpl.end());
+    name.push_back('\0');
+    const int fd = mkstemp(name.data());
+    if (fd < 0)
+        return NULL;
+    unlink(name.data());
+    FILE *f = fdopen(fd, "w+b");
+    if (f == NULL) {
+        ::close(fd);
+        return NULL;
+    }
+    buf.resize(bufsize);
+    setvbuf(f, buf.data(), _IOFBF, bufsize);
+    return f;
+}
+
+/* Rewind a spill file to read it from the beginning; return false on
+   error */
+static bool rewind_spill( FILE *f )
+{
+    return (fflush(f) == 0 && fseek(f, 0, SEEK_SET) == 0);
+}
+
+/* Call fn(r) for each record r of type T stored in spill file `f`;
+   return false on I/O error */
+template<typename T, typename F>
+static bool scan_spill( FILE *f, std::vector<T> &chunk, F fn )
+{
+    if (!rewind_spill(f))
+        return false;
+    chunk.resize(CHUNK_SIZE);
+    size_t n;
+    while ((n = fread(chunk.data(), sizeof(T), CHUNK_SIZE, f)) > 0) {
+        for (size_t i=0; i<n; i++)
+            fn(chunk[i]);
+    }
+    return !ferror(f);
+}
+
+external_counter::external_counter( ) :
+    budget(0),
+    a_file(NULL),
+    b_file(NULL),
+    n_A(0),
+    n_B(0),
+    min_left(std::numeric_limits<int64_t>::max()),
+    max_left(std::numeric_limits<int64_t>::min()),
+    n_slabs(0),
+    io_error(false)
+{ }
+
+external_counter::~external_counter( )
+{
+    close();
+}
+
+void external_counter::close( void )
+{
+    if (a_file) fclose(a_file);
+    if (b_file) fclose(b_file);
+    a_file = b_file = NULL;
+}
+
+bool external_counter::open( const char *tmp_dir, size_t mem_budget )
+{
+    close();
+    dir = tmp_dir;
+    budget = mem_budget;
+    n_A = n_B = 0;
+    min_left = std::numeric_limits<int64_t>::max();
+    max_left = std::numeric_limits<int64_t>::min();
+    n_slabs = 0;
+    io_error = false;
+    a_file = create_spill(dir, a_buf, SPILL_BUFSIZE);
+    b_file = create_spill(dir, b_buf, SPILL_BUFSIZE);
+    return (a_file != NULL && b_file != NULL);
+}
+
+size_t external_counter::add_A( int64_t left, int64_t right )
+{
+    assert(a_file != NULL);
+    assert(left <= right);
+    const a_rec r = { left, right, int64_t(n_A) };
+    if (fwrite(&r, sizeof(r), 1, a_file) != 1)
+        io_error = true;
+    min_left = std::min(min_left, left);
+    max_left = std::max(max_left, left);
+    return n_A++;
+}
+
+void external_counter::add_B( int64_t left, int64_t right )
+{
+    assert(b_file != NULL);
+    const b_rec r = { left, right };
+    if (fwrite(&r, sizeof(r), 1, b_file) != 1)
+        io_error = true;
+    min_left = std::min(min_left, left);
+    max_left = std::max(max_left, left);
+    n_B++;
+}
+
+bool external_counter::count( std::vector<int64_t> &counts, size_t &n_intersections )
+{
+    assert(a_file != NULL && b_file != NULL);
+    counts.assign(n_A, 0);
+    n_intersections = 0;
+    n_slabs = 0;
+    if (io_error)
+        return false;
+    if (n_A == 0 || n_B == 0) {
+        close();
+        return true;
+    }
+
+    std::vector<a_rec> a_chunk;
+    std::vector<b_rec> b_chunk;
+
+    /* Build a histogram of the left endpoints, and cut the coordinate
+       axis into slabs so that each slab holds at most `max_slab`
+       intervals. A single bucket with more intervals than that gets a
+       slab on its own. */
+    const size_t max_slab = std::max(budget / BYTES_PER_INTERVAL, size_t(1));
+    const uint64_t width = (uint64_t(max_left) - uint64_t(min_left)) / N_BUCKETS + 1;
+    std::vector<size_t> hist(N_BUCKETS, 0);
+    const int64_t lo = min_left;
+    if (!scan_spill(a_file, a_chunk, [&](const a_rec &r) { hist[(uint64_t(r.left) - uint64_t(lo)) / width]++; }) ||
+        !scan_spill(b_file, b_chunk, [&](const b_rec &r) { hist[(uint64_t(r.left) - uint64_t(lo)) / width]++; }))
+        return false;
+
+    std::vector<int64_t> start; // start[k] is the first coordinate of slab k
+    start.push_back(min_left);
+    size_t acc = 0;
+    for (size_t b=0; b<N_BUCKETS; b++) {
+        if (acc > 0 && acc + hist[b] > max_slab) {
+            start.push_back(int64_t(uint64_t(min_left) + b * width));
+            acc = 0;
+        }
+        acc += hist[b];
+    }
+    n_slabs = start.size();
+
+    count_workspace ws;
+    std::vector<a_rec> pending;     // parts of intervals of A carried over to the next slab
+    std::vector<int64_t> carried;   // sorted right endpoints of B carried over to the next slab
+    std::vector<a_rec> slab_A;
+    std::vector<int64_t> slab_ids;
+    interval_set<int64_t> A, B;
+    std::vector<int64_t> c;
+
+    for (size_t g=0; g<n_slabs; g+=MAX_OPEN_SLABS) {
+        /* Distribute the intervals whose left endpoint belongs to
+           slabs g, g+1, ... to the slab files */
+        const size_t n_open = std::min(MAX_OPEN_SLABS, n_slabs - g);
+        const size_t bufsize = std::min(std::max(budget / (4*n_open), SLAB_BUFSIZE_MIN), SLAB_BUFSIZE_MAX);
+        std::vector<FILE*> a_slab(n_open, (FILE*)NULL), b_slab(n_open, (FILE*)NULL);
+        std::vector< std::vector<char> > a_slab_buf(n_open), b_slab_buf(n_open);
+        bool ok = true;
+        for (size_t k=0; k<n_open && ok; k++) {
+            a_slab[k] = create_spill(dir, a_slab_buf[k], bufsize);
+            b_slab[k] = create_spill(dir, b_slab_buf[k], bufsize);
+            ok = (a_slab[k] != NULL && b_slab[k] != NULL);
+        }
+        const int64_t g_lo = start[g];
+        const bool last_group = (g + n_open == n_slabs);
+        const int64_t g_hi = (last_group ? std::numeric_limits<int64_t>::max() : start[g + n_open]);
+        if (ok) {
+            ok = scan_spill(a_file, a_chunk, [&](const a_rec &r) {
+                    if (r.left >= g_lo && (last_group || r.left < g_hi)) {
+                        const size_t k = std::upper_bound(start.begin() + g, start.begin() + g + n_open, r.left) - start.begin() - 1 - g;
+                        if (fwrite(&r, sizeof(r), 1, a_slab[k]) != 1) io_error = true;
+                    }
+                }) &&
+                scan_spill(b_file, b_chunk, [&](const b_rec &r) {
+                    if (r.left >= g_lo && (last_group || r.left < g_hi)) {
+                        const size_t k = std::upper_bound(start.begin() + g, start.begin() + g + n_open, r.left) - start.begin() - 1 - g;
+                        if (fwrite(&r, sizeof(r), 1, b_slab[k]) != 1) io_error = true;
+                    }
+                }) &&
+                !io_error;
+        }
+
+        /* Process the slabs of this group in order */
+        for (size_t k=0; k<n_open && ok; k++) {
+            const size_t s = g + k;
+            const bool last = (s + 1 == n_slabs);
+            const int64_t end = (last ? std::numeric_limits<int64_t>::max() : start[s+1]);
+
+            /* The intervals of A that start in this slab come first,
+               followed by the parts carried over from the previous
+               slab; all of them are clipped to the end of the slab,
+               and the remainder is carried over to the next one. */
+            A.clear();
+            slab_ids.clear();
+            std::vector<a_rec> next_pending;
+            const auto add_to_slab = [&](const a_rec &r) {
+                A.push_back(r.left, (last ? r.right : std::min(r.right, end - 1)));
+                slab_ids.push_back(r.id);
+                if (!last && r.right >= end) {
+                    const a_rec rest = { end, r.right, r.id };
+                    next_pending.push_back(rest);
+                }
+            };
+            ok = scan_spill(a_slab[k], a_chunk, add_to_slab);
+            const size_t n_first = A.size();
+            std::for_each(pending.begin(), pending.end(), add_to_slab);
+            pending.swap(next_pending);
+
+            /* An empty interval [l, l-1] of B (an alignment without a
+               sequence) overlaps the intervals of A that contain both
+               l-1 and l, as in the in-memory kernel. If l is the
+               first coordinate of the slab, these are exactly the
+               parts carried over from the previous slab, which the
+               kernel can not see since they are clipped at l. */
+            B.clear();
+            size_t n_empty_at_start = 0;
+            ok = ok && scan_spill(b_slab[k], b_chunk, [&](const b_rec &r) {
+                    B.push_back(r.left, r.right);
+                    if (s > 0 && r.right < r.left && r.left == start[s])
+                        n_empty_at_start++;
+                });
+            if (!ok)
+                break;
+
+            std::cout << "Slab " << s+1 << " of " << n_slabs << " (" << A.size()
+                      << " + " << B.size() << " intervals)... " << std::flush;
+            n_intersections += count_intersections(A, B, c, &ws);
+            for (size_t i=0; i<A.size(); i++)
+                counts[slab_ids[i]] += c[i];
+
+            /* The intervals of B carried over from the previous slabs
+               start before any interval of A in this slab, so they
+               overlap it iff their right endpoint is not smaller than
+               its left endpoint. The parts carried over from the
+               previous slab have already been counted against
+               them. */
+            for (size_t i=0; i<n_first; i++) {
+                const int64_t nc = carried.end() - std::lower_bound(carried.begin(), carried.end(), A.left(i));
+                counts[slab_ids[i]] += nc;
+                n_intersections += nc;
+            }
+            for (size_t i=n_first; i<A.size(); i++) {
+                counts[slab_ids[i]] += n_empty_at_start;
+                n_intersections += n_empty_at_start;
+            }
+            std::cout << "done" << std::endl;
+
+            if (!last) {
+                carried.erase(carried.begin(), std::lower_bound(carried.begin(), carried.end(), end));
+                for (size_t j=0; j<B.size(); j++) {
+                    if (B.right(j) >= end)
+                        carried.push_back(B.right(j));
+                }
+                std::sort(carried.begin(), carried.end());
+            }
+        }
+
+        for (size_t k=0; k<n_open; k++) {
+            if (a_slab[k]) fclose(a_slab[k]);
+            if (b_slab[k]) fclose(b_slab[k]);
+        }
+        if (!ok)
+            return false;
+    }
+    close();
+    return true;
+}
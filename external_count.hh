@@ -0,0 +1,133 @@
+/****************************************************************************
+ *
+ * external_count.hh - out-of-core counting of intersections
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef EXTERNAL_COUNT_HH
+#define EXTERNAL_COUNT_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Counts how many intervals of a set B overlap each interval of a
+ * set A, when the intervals do not fit in memory. The intervals are
+ * first appended to spill files; then, the coordinate axis is
+ * partitioned into slabs, each one containing (roughly) as many
+ * intervals as fit in the memory budget, and the intervals are
+ * distributed to one spill file per slab according to their left
+ * endpoint. Each slab is then loaded and processed with the
+ * in-memory kernel (count_intersections()):
+ *
+ * - the intervals of A that extend past the end of the slab are
+ *   clipped, and the remaining part is carried over to the next
+ *   slab, where it is only counted against the intervals of B that
+ *   start in that slab;
+ *
+ * - the right endpoints of the intervals of B that extend past the
+ *   end of the slab are carried over to the next slab, where they
+ *   are counted against the intervals of A that start there.
+ *
+ * The result is the same as with the in-memory kernel. Coordinates
+ * are 64 bits wide, so that intervals on different contigs can be
+ * mapped to disjoint ranges of the same axis. All I/O is sequential,
+ * in large blocks.
+ */
+class external_counter {
+public:
+    external_counter();
+    ~external_counter();
+
+    /**
+     * Create the spill files in the directory `tmp_dir`; the memory
+     * used by each slab is about `mem_budget` bytes. Return false on
+     * error.
+     */
+    bool open( const char *tmp_dir, size_t mem_budget );
+
+    /**
+     * Add the interval [left, right] to A; return its ID (0, 1, ...)
+     */
+    size_t add_A( int64_t left, int64_t right );
+
+    /**
+     * Add the interval [left, right] to B
+     */
+    void add_B( int64_t left, int64_t right );
+
+    /**
+     * Store in counts[i] the number of intervals in B that overlap
+     * the interval of A with ID i, and in `n_intersections` the total
+     * number of intersections. All spill files are removed. Return
+     * false on I/O error.
+     */
+    bool count( std::vector<int64_t> &counts, size_t &n_intersections );
+
+    size_t size_A( void ) const { return n_A; }
+    size_t size_B( void ) const { return n_B; }
+
+    /**
+     * Number of slabs used by the last call to count()
+     */
+    size_t slabs( void ) const { return n_slabs; }
+
+    /* Estimated number of bytes used by the in-memory kernel for each
+       interval: the coordinates (16 bytes), the endpoints and the
+       scratch area of the sort (2*2*16 bytes), and the IDs and the
+       counts of the intervals of A (16 bytes) */
+    static const size_t BYTES_PER_INTERVAL = 96;
+
+    struct a_rec {
+        int64_t left;
+        int64_t right;
+        int64_t id;
+    };
+
+    struct b_rec {
+        int64_t left;
+        int64_t right;
+    };
+
+private:
+    external_counter( const external_counter & );
+    external_counter& operator=( const external_counter & );
+
+    void close( void );
+
+    std::string dir;
+    size_t budget;
+    FILE *a_file;
+    FILE *b_file;
+    std::string a_name;
+    std::string b_name;
+    std::vector<char> a_buf;
+    std::vector<char> b_buf;
+    size_t n_A;
+    size_t n_B;
+    int64_t min_left;
+    int64_t max_left;
+    size_t n_slabs;
+    bool io_error;
+};
+
+#endif /* EXTERNAL_COUNT_HH */
@@ -0,0 +1,289 @@
+/****************************************************************************
+ *
+ * generate.cc - synthetic workloads
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include "generate.hh"
+
+const char *distribution_names[N_DISTRIBUTIONS] = { "uniform", "exome", "heavy", "nested" };
+
+/* Each stream of random numbers produces the intervals of a chunk of
+   CHUNK_SIZE consecutive positions of the output */
+static const size_t CHUNK_SIZE = 1 << 16;
+
+/* Length of the coordinate axis for each interval generated (except
+   for the uniform distribution), up to MAX_SPAN */
+static const int64_t SPAN_PER_INTERVAL = 100;
+static const int64_t MAX_SPAN = 1 << 30;
+
+/* IDs of the streams of random numbers; the ID of the stream of
+   chunk c of set s is (s << STREAM_SHIFT) | c */
+enum { STREAM_A, STREAM_B, STREAM_HOTSPOTS, STREAM_GENES, STREAM_WEIGHTS };
+static const int STREAM_SHIFT = 40;
+
+static uint64_t splitmix64( uint64_t &x )
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * xoshiro256** generator, whose state is derived from the seed and
+ * the ID of the stream with splitmix64. The random variates are
+ * computed here, rather than with <random>, so that the output does
+ * not depend on the C++ library.
+ */
+class rng_stream {
+public:
+    rng_stream( uint64_t seed, uint64_t stream )
+    {
+        uint64_t x = seed;
+        x = splitmix64(x) ^ stream;
+        for (int i=0; i<4; i++)
+            s[i] = splitmix64(x);
+    }
+
+    uint64_t next( void )
+    {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    /* uniform in [0, 1) */
+    double uniform01( void ) { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    /* uniform integer in [a, b] */
+    int64_t uniform( int64_t a, int64_t b )
+    {
+        return std::min(b, a + int64_t(uniform01() * double(b - a + 1)));
+    }
+
+    double exponential( double mean ) { return -mean * std::log1p(-uniform01()); }
+
+    double normal( void )
+    {
+        const double r = std::sqrt(-2.0 * std::log1p(-uniform01()));
+        return r * std::cos(2.0 * M_PI * uniform01());
+    }
+
+private:
+    static uint64_t rotl( uint64_t x, int k ) { return (x << k) | (x >> (64 - k)); }
+    uint64_t s[4];
+};
+
+bool parse_distribution( const char *name, distribution_t &dist )
+{
+    for (int d=0; d<N_DISTRIBUTIONS; d++) {
+        if (!strcmp(name, distribution_names[d])) {
+            dist = distribution_t(d);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Resize `v` to `n` intervals, and fill it in parallel: the interval
+ * at position i is set by gen(rng, i, left, right), where `rng` is
+ * the stream of the chunk that contains i.
+ */
+template<typename Gen>
+static void fill_chunks( interval_set<int32_t> &v, size_t n, uint64_t seed, uint64_t set_id, Gen gen )
+{
+    v.resize(n);
+    int32_t *lefts = v.left();
+    int32_t *rights = v.right();
+    const long n_chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (long c=0; c<n_chunks; c++) {
+        rng_stream rng(seed, (set_id << STREAM_SHIFT) | uint64_t(c));
+        const size_t end = std::min(n, (c + 1) * CHUNK_SIZE);
+        for (size_t i=c*CHUNK_SIZE; i<end; i++) {
+            int64_t left, right;
+            gen(rng, i, left, right);
+            assert(0 <= right - left);
+            lefts[i] = int32_t(left);
+            rights[i] = int32_t(right);
+        }
+    }
+}
+
+static void generate_uniform( interval_set<int32_t> &v, size_t n, uint64_t seed, uint64_t set_id )
+{
+    fill_chunks(v, n, seed, set_id, [](rng_stream &rng, size_t, int64_t &left, int64_t &right) {
+            left = rng.uniform(-100000, 100000);
+            right = left + rng.uniform(10, 1000);
+        });
+}
+
+/* Pareto-distributed lengths with shape HEAVY_ALPHA (infinite
+   variance) and minimum HEAVY_MIN_LEN, truncated to HEAVY_MAX_LEN */
+static const double HEAVY_ALPHA = 1.2;
+static const double HEAVY_MIN_LEN = 50;
+static const double HEAVY_MAX_LEN = 1 << 24;
+
+static void generate_heavy( interval_set<int32_t> &v, size_t n, int64_t span, uint64_t seed, uint64_t set_id )
+{
+    fill_chunks(v, n, seed, set_id, [span](rng_stream &rng, size_t, int64_t &left, int64_t &right) {
+            const double len = HEAVY_MIN_LEN * std::pow(1.0 - rng.uniform01(), -1.0 / HEAVY_ALPHA);
+            left = rng.uniform(0, span - 1);
+            right = left + int64_t(std::min(len, HEAVY_MAX_LEN));
+        });
+}
+
+/* One hotspot every NESTED_HOTSPOT_SIZE intervals; the lengths are
+   10*2^k, with k uniform in [0, NESTED_MAX_LEVEL], and the centers
+   of the intervals of a hotspot differ by a small fraction of their
+   lengths */
+static const size_t NESTED_HOTSPOT_SIZE = 10000;
+static const int NESTED_MAX_LEVEL = 19;
+static const int64_t NESTED_MARGIN = 10 << NESTED_MAX_LEVEL;
+
+static void generate_nested( interval_set<int32_t> &v, size_t n, const std::vector<int64_t> &hotspots, uint64_t seed, uint64_t set_id )
+{
+    const int64_t n_hotspots = hotspots.size();
+    fill_chunks(v, n, seed, set_id, [&hotspots, n_hotspots](rng_stream &rng, size_t, int64_t &left, int64_t &right) {
+            const int64_t center = hotspots[rng.uniform(0, n_hotspots - 1)];
+            const int64_t len = int64_t(10) << rng.uniform(0, NESTED_MAX_LEVEL);
+            const int64_t shift = rng.uniform(-len/16, len/16);
+            left = center + shift - len/2;
+            right = left + len;
+        });
+}
+
+/* The exome: EXONS_PER_GENE consecutive targets belong to the same
+   gene, and start within GENE_LEN bases from the start of the gene;
+   the length of the targets is EXON_MIN_LEN plus an exponential with
+   mean EXON_MEAN_EXTRA_LEN, up to EXON_MAX_LEN. On average, there is
+   a gene every GENE_SPACING bases (up to MAX_SPAN). */
+static const size_t EXONS_PER_GENE = 10;
+static const int64_t GENE_LEN = 50000;
+static const int64_t GENE_SPACING = 150000;
+static const double EXON_MIN_LEN = 50;
+static const double EXON_MEAN_EXTRA_LEN = 120;
+static const double EXON_MAX_LEN = 5000;
+static const int64_t READ_LEN = 100;
+static const double ON_TARGET = 0.8;
+static const double CAPTURE_SIGMA = 0.7;
+
+static void generate_exome( size_t n, size_t m, uint64_t seed,
+                            interval_set<int32_t> &A,
+                            interval_set<int32_t> &B )
+{
+    const size_t n_genes = (n + EXONS_PER_GENE - 1) / EXONS_PER_GENE;
+    const int64_t span = std::max(int64_t(1), std::min(MAX_SPAN, int64_t(n_genes) * GENE_SPACING));
+    std::vector<int64_t> genes(n_genes);
+    rng_stream gene_rng(seed, uint64_t(STREAM_GENES) << STREAM_SHIFT);
+    for (size_t g=0; g<n_genes; g++) {
+        genes[g] = READ_LEN + gene_rng.uniform(0, span - 1);
+    }
+    fill_chunks(A, n, seed, STREAM_A, [&genes](rng_stream &rng, size_t i, int64_t &left, int64_t &right) {
+            const double len = EXON_MIN_LEN + rng.exponential(EXON_MEAN_EXTRA_LEN);
+            left = genes[i / EXONS_PER_GENE] + rng.uniform(0, GENE_LEN - 1);
+            right = left + int64_t(std::min(len, EXON_MAX_LEN));
+        });
+    if (n == 0) {
+        // no targets: all reads are off-target
+        fill_chunks(B, m, seed, STREAM_B, [span](rng_stream &rng, size_t, int64_t &left, int64_t &right) {
+                left = rng.uniform(0, span - 1);
+                right = left + READ_LEN;
+            });
+        return;
+    }
+
+    // the capture efficiency of each target; `cdf` is the cumulative
+    // (unnormalized) distribution of the targets of on-target reads
+    std::vector<double> cdf(n);
+    const long n_chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+#pragma omp parallel for schedule(static)
+    for (long c=0; c<n_chunks; c++) {
+        rng_stream rng(seed, (uint64_t(STREAM_WEIGHTS) << STREAM_SHIFT) | uint64_t(c));
+        const size_t end = std::min(n, (c + 1) * CHUNK_SIZE);
+        for (size_t i=c*CHUNK_SIZE; i<end; i++) {
+            cdf[i] = std::exp(CAPTURE_SIGMA * rng.normal());
+        }
+    }
+    std::partial_sum(cdf.begin(), cdf.end(), cdf.begin());
+
+    const int32_t *lA = A.left();
+    const int32_t *rA = A.right();
+    fill_chunks(B, m, seed, STREAM_B, [&cdf, lA, rA, span](rng_stream &rng, size_t, int64_t &left, int64_t &right) {
+            if (rng.uniform01() < ON_TARGET) {
+                const size_t t = std::min(cdf.size() - 1,
+                                          size_t(std::upper_bound(cdf.begin(), cdf.end(), rng.uniform01() * cdf.back()) - cdf.begin()));
+                left = rng.uniform(lA[t] - READ_LEN + 1, rA[t] - 1);
+            } else {
+                left = rng.uniform(0, span - 1);
+            }
+            right = left + READ_LEN;
+        });
+}
+
+void generate_intervals( distribution_t dist,
+                         size_t n, size_t m,
+                         uint64_t seed,
+                         interval_set<int32_t> &A,
+                         interval_set<int32_t> &B )
+{
+    const int64_t span = std::max(int64_t(1), std::min(MAX_SPAN, int64_t(n + m) * SPAN_PER_INTERVAL));
+
+    switch (dist) {
+    case DIST_UNIFORM:
+        generate_uniform(A, n, seed, STREAM_A);
+        generate_uniform(B, m, seed, STREAM_B);
+        break;
+    case DIST_EXOME:
+        generate_exome(n, m, seed, A, B);
+        break;
+    case DIST_HEAVY:
+        generate_heavy(A, n, span, seed, STREAM_A);
+        generate_heavy(B, m, span, seed, STREAM_B);
+        break;
+    case DIST_NESTED: {
+        const size_t n_hotspots = std::max(size_t(1), (n + m) / NESTED_HOTSPOT_SIZE);
+        std::vector<int64_t> hotspots(n_hotspots);
+        rng_stream rng(seed, uint64_t(STREAM_HOTSPOTS) << STREAM_SHIFT);
+        for (size_t h=0; h<n_hotspots; h++) {
+            hotspots[h] = NESTED_MARGIN + rng.uniform(0, span - 1);
+        }
+        generate_nested(A, n, hotspots, seed, STREAM_A);
+        generate_nested(B, m, hotspots, seed, STREAM_B);
+        break;
+    }
+    default:
+        assert(false);
+    }
+}
@@ -0,0 +1,79 @@
+/****************************************************************************
+ *
+ * generate.hh - synthetic workloads
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef GENERATE_HH
+#define GENERATE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include "interval_set.hh"
+
+/**
+ * Distributions of the synthetic intervals:
+ *
+ * - uniform: left endpoints uniform in [-100000, 100000], lengths
+ *   uniform in [10, 1000] (the original random input of -N);
+ *
+ * - exome: A are exon-like targets, clustered in genes; B are reads
+ *   of 100 bases, most of which pile up on the targets. Each
+ *   on-target read picks its target at random, so that the number of
+ *   reads of each target is (approximately) Poisson-distributed, with
+ *   a mean that varies lognormally across targets, as the capture
+ *   efficiency does; the remaining reads are off-target;
+ *
+ * - heavy: uniform left endpoints, with Pareto-distributed lengths
+ *   (a few intervals are very long);
+ *
+ * - nested: intervals centered on a few hotspots, with lengths
+ *   spanning several orders of magnitude, so that most intervals are
+ *   contained in longer ones.
+ */
+enum distribution_t {
+    DIST_UNIFORM,
+    DIST_EXOME,
+    DIST_HEAVY,
+    DIST_NESTED,
+    N_DISTRIBUTIONS
+};
+
+extern const char *distribution_names[N_DISTRIBUTIONS];
+
+/**
+ * Set `dist` to the distribution called `name`; return false if
+ * there is no such distribution.
+ */
+bool parse_distribution( const char *name, distribution_t &dist );
+
+/**
+ * Fill `A` with `n` and `B` with `m` synthetic intervals of the given
+ * distribution. The intervals are generated in parallel from
+ * independent random streams, one for each fixed-size chunk of the
+ * output; the result only depends on `seed`, not on the number of
+ * threads.
+ */
+void generate_intervals( distribution_t dist,
+                         size_t n, size_t m,
+                         uint64_t seed,
+                         interval_set<int32_t> &A,
+                         interval_set<int32_t> &B );
+
+#endif /* GENERATE_HH */
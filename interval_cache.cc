@@ -0,0 +1,315 @@
+/****************************************************************************
+ *
+ * interval_cache.cc - columnar binary cache of a set of intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+/* Layout of the cache file. All offsets are in bytes from the
+   beginning of the file, and all columns start at a multiple of
+   ALIGN bytes.
+
+   +--------------------+
+   | cache_header       |
+   +--------------------+
+   | columns of contig 0|  raw: lefts, rights
+   | columns of contig 1|  delta: block offsets, encoded blocks
+   | ...                |
+   +--------------------+
+   | cache_dir_entry    |  footer: one entry for each contig;
+   | ...                |  header.dir_offset points here
+   +--------------------+
+   | contig names       |
+   +--------------------+
+
+   A delta-encoded column holds blocks of DELTA_BLOCK intervals; the
+   block offsets (relative to the first block, plus the end of the
+   last block) allow the blocks to be decoded in parallel. In each
+   block, interval i is encoded as the zigzag varint of left[i] -
+   left[i-1] (left[-1] = 0 in each block), followed by the varint of
+   right[i] - left[i]. */
+
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include "interval_cache.hh"
+
+static const char CACHE_MAGIC[8] = { 'I', 'N', 'T', 'X', 'C', 'A', 'C', '1' };
+static const uint64_t ALIGN = 64;
+static const size_t DELTA_BLOCK = 1 << 16;
+
+struct cache_header {
+    char magic[8];
+    uint64_t n_contigs;
+    uint64_t dir_offset;
+};
+
+struct cache_dir_entry {
+    uint64_t name_offset;
+    uint64_t name_len;
+    uint64_t n;                 // number of intervals
+    uint64_t encoding;          // cache_encoding_t
+    uint64_t col0, col1;        // raw: lefts, rights; delta: block offsets, blocks
+    uint64_t data_len;          // delta: total length of the blocks
+};
+
+/**
+ * Pad the file to a multiple of ALIGN bytes, after `len` bytes
+ */
+static void pad( std::ofstream &out, size_t len )
+{
+    static const char zeros[ALIGN] = { 0 };
+    if (len % ALIGN)
+        out.write(zeros, ALIGN - len % ALIGN);
+}
+
+/**
+ * Write `len` bytes from `buf` to `out`, padding the file to a
+ * multiple of ALIGN bytes; return the offset where the data start.
+ */
+static uint64_t write_aligned( std::ofstream &out, const void *buf, size_t len )
+{
+    const uint64_t ofs = out.tellp();
+    out.write(static_cast<const char*>(buf), len);
+    pad(out, len);
+    return ofs;
+}
+
+static void put_varint( std::string &out, uint64_t x )
+{
+    while (x >= 0x80) {
+        out.push_back(char(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back(char(x));
+}
+
+/* Read a varint that ends before `end`; a truncated varint (only in a
+   corrupt cache) is decoded from the bytes before `end`, so that the
+   decoding of a block never reads past it */
+static uint64_t get_varint( const uint8_t *&p, const uint8_t *end )
+{
+    uint64_t x = 0;
+    int shift = 0;
+    while (p < end) {
+        const uint8_t byte = *p++;
+        if (shift < 64)
+            x |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            break;
+        shift += 7;
+    }
+    return x;
+}
+
+static uint64_t zigzag( int64_t x ) { return (uint64_t(x) << 1) ^ uint64_t(x >> 63); }
+static int64_t unzigzag( uint64_t x ) { return int64_t(x >> 1) ^ -int64_t(x & 1); }
+
+static size_t n_blocks( size_t n ) { return (n + DELTA_BLOCK - 1) / DELTA_BLOCK; }
+
+/**
+ * Write the delta encoding of `v`; set `blocks` and `data` to the
+ * offsets of the block offsets and of the blocks, and return the
+ * total length of the blocks.
+ */
+static uint64_t write_delta( std::ofstream &out, const interval_set<int32_t> &v, uint64_t &blocks, uint64_t &data )
+{
+    const long nb = n_blocks(v.size());
+    std::vector<std::string> enc(nb);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (long b=0; b<nb; b++) {
+        const size_t start = b * DELTA_BLOCK;
+        const size_t end = std::min(v.size(), start + DELTA_BLOCK);
+        int64_t prev = 0;
+        for (size_t i=start; i<end; i++) {
+            put_varint(enc[b], zigzag(int64_t(v.left(i)) - prev));
+            put_varint(enc[b], zigzag(int64_t(v.right(i)) - v.left(i)));
+            prev = v.left(i);
+        }
+    }
+    std::vector<uint64_t> ofs(nb + 1, 0);
+    for (long b=0; b<nb; b++) {
+        ofs[b+1] = ofs[b] + enc[b].size();
+    }
+    blocks = write_aligned(out, ofs.data(), ofs.size() * sizeof(uint64_t));
+    data = out.tellp();
+    for (long b=0; b<nb; b++) {
+        out.write(enc[b].data(), enc[b].size());
+    }
+    pad(out, ofs[nb]);
+    return ofs[nb];
+}
+
+bool write_interval_cache( const char *fname,
+                           const std::map<int32_t, interval_set<int32_t> > &B,
+                           const std::vector<std::string> &names,
+                           cache_encoding_t encoding )
+{
+    std::ofstream out(fname, std::ios::binary);
+    if (out.fail())
+        return false;
+
+    cache_header hdr;
+    memcpy(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.n_contigs = names.size();
+    hdr.dir_offset = 0;
+    write_aligned(out, &hdr, sizeof(hdr));
+
+    std::vector<cache_dir_entry> dir;
+    std::string all_names;
+    const interval_set<int32_t> empty;
+    for (size_t tid=0; tid<names.size(); tid++) {
+        const std::string &name = names[tid];
+        const auto c = B.find(tid);
+        const interval_set<int32_t> &v = (c == B.end() ? empty : c->second);
+        cache_dir_entry e;
+        e.name_offset = all_names.size();
+        e.name_len = name.size();
+        all_names += name;
+        e.n = v.size();
+        e.encoding = encoding;
+        if (encoding == CACHE_RAW) {
+            e.col0 = write_aligned(out, v.left(), v.size() * sizeof(int32_t));
+            e.col1 = write_aligned(out, v.right(), v.size() * sizeof(int32_t));
+            e.data_len = 0;
+        } else {
+            e.data_len = write_delta(out, v, e.col0, e.col1);
+        }
+        dir.push_back(e);
+    }
+    hdr.dir_offset = write_aligned(out, dir.data(), dir.size() * sizeof(cache_dir_entry));
+    const uint64_t names_offset = write_aligned(out, all_names.data(), all_names.size());
+    for (size_t i=0; i<dir.size(); i++) {
+        dir[i].name_offset += names_offset;
+    }
+    out.seekp(hdr.dir_offset);
+    out.write(reinterpret_cast<const char*>(dir.data()), dir.size() * sizeof(cache_dir_entry));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.close();
+    return !out.fail();
+}
+
+bool is_interval_cache( const char *fname )
+{
+    std::ifstream in(fname, std::ios::binary);
+    char magic[sizeof(CACHE_MAGIC)];
+    return (in.read(magic, sizeof(magic)) && !memcmp(magic, CACHE_MAGIC, sizeof(magic)));
+}
+
+/* Return true iff an array of `n` elements of `elem_size` bytes at
+   offset `offset` is entirely inside a file of `size` bytes */
+static bool in_file( uint64_t offset, uint64_t n, uint64_t elem_size, uint64_t size )
+{
+    return (n <= size / elem_size && offset <= size - n * elem_size);
+}
+
+/* Return true iff the `nb` + 1 block offsets are nondecreasing and
+   at most `data_len`, so that every block starts inside the data */
+static bool valid_blocks( const uint64_t *blocks, uint64_t nb, uint64_t data_len )
+{
+    for (uint64_t b=0; b<nb; b++) {
+        if (blocks[b] > blocks[b+1])
+            return false;
+    }
+    return (blocks[nb] == data_len);
+}
+
+bool interval_cache::open( const char *fname )
+{
+    dir.clear();
+    if (!file.open(fname))
+        return false;
+
+    const char *base = file.data();
+    const uint64_t size = file.size();
+    cache_header hdr;
+    if (size < sizeof(hdr))
+        return false;
+    memcpy(&hdr, base, sizeof(hdr));
+    if (memcmp(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic)) ||
+        hdr.dir_offset > size ||
+        hdr.n_contigs > (size - hdr.dir_offset) / sizeof(cache_dir_entry))
+        return false;
+
+    const cache_dir_entry *entries = reinterpret_cast<const cache_dir_entry*>(base + hdr.dir_offset);
+    for (uint64_t c=0; c<hdr.n_contigs; c++) {
+        const cache_dir_entry &e = entries[c];
+        contig ct;
+        if (!in_file(e.name_offset, e.name_len, 1, size))
+            return false;
+        ct.name.assign(base + e.name_offset, e.name_len);
+        ct.n = e.n;
+        ct.lefts = ct.rights = NULL;
+        ct.blocks = NULL;
+        ct.data = NULL;
+        if (e.encoding == CACHE_RAW) {
+            if (!in_file(e.col0, e.n, sizeof(int32_t), size) ||
+                !in_file(e.col1, e.n, sizeof(int32_t), size))
+                return false;
+            ct.encoding = CACHE_RAW;
+            ct.lefts = reinterpret_cast<const int32_t*>(base + e.col0);
+            ct.rights = reinterpret_cast<const int32_t*>(base + e.col1);
+        } else if (e.encoding == CACHE_DELTA) {
+            if (e.n > size ||
+                !in_file(e.col0, n_blocks(e.n) + 1, sizeof(uint64_t), size) ||
+                !in_file(e.col1, e.data_len, 1, size))
+                return false;
+            ct.encoding = CACHE_DELTA;
+            ct.blocks = reinterpret_cast<const uint64_t*>(base + e.col0);
+            ct.data = reinterpret_cast<const uint8_t*>(base + e.col1);
+            if (!valid_blocks(ct.blocks, n_blocks(e.n), e.data_len))
+                return false;
+        } else {
+            return false;
+        }
+        dir.push_back(ct);
+    }
+    return true;
+}
+
+void interval_cache::get( size_t c, interval_set<int32_t> &v ) const
+{
+    const contig &ct = dir[c];
+    if (ct.encoding == CACHE_RAW) {
+        interval_set<int32_t> view(ct.lefts, ct.rights, ct.n);
+        v.swap(view);
+        return;
+    }
+
+    v.clear();
+    v.resize(ct.n);
+    int32_t *lefts = v.left();
+    int32_t *rights = v.right();
+    const long nb = n_blocks(ct.n);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (long b=0; b<nb; b++) {
+        const uint8_t *p = ct.data + ct.blocks[b];
+        const uint8_t *p_end = ct.data + ct.blocks[b+1];
+        const size_t start = b * DELTA_BLOCK;
+        const size_t end = std::min(ct.n, start + DELTA_BLOCK);
+        int64_t left = 0;
+        for (size_t i=start; i<end; i++) {
+            left += unzigzag(get_varint(p, p_end));
+            lefts[i] = int32_t(left);
+            rights[i] = int32_t(left + unzigzag(get_varint(p, p_end)));
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/****************************************************************************
+ *
+ * interval_cache.hh - columnar binary cache of a set of intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef INTERVAL_CACHE_HH
+#define INTERVAL_CACHE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "interval_set.hh"
+#include "mapped_file.hh"
+
+/**
+ * Encodings of the columns of a contig:
+ *
+ * - raw: the left and right endpoints are stored as arrays of
+ *   int32_t, that are used in place (without copying them);
+ *
+ * - delta: the differences between consecutive left endpoints and
+ *   the lengths (right - left) are stored as variable-length
+ *   integers, in independent blocks that are decoded in parallel.
+ *   For a BAM file sorted by coordinate, this takes less than half
+ *   the space of the raw encoding.
+ */
+enum cache_encoding_t {
+    CACHE_RAW,
+    CACHE_DELTA
+};
+
+/**
+ * Columnar binary cache of the intervals of a set B (e.g., the
+ * alignments of a BAM file), organized by contig. The cache file is
+ * mapped in memory, so that the intervals can be reloaded without
+ * parsing anything.
+ */
+class interval_cache {
+public:
+    /**
+     * Map the cache file `fname` in memory; return false if the file
+     * can not be opened or is not a valid cache.
+     */
+    bool open( const char *fname );
+
+    size_t n_contigs( void ) const { return dir.size(); }
+    const std::string &name( size_t c ) const { return dir[c].name; }
+    size_t size( size_t c ) const { return dir[c].n; }
+
+    /**
+     * Set `v` to the intervals of contig `c`. If the contig is stored
+     * with the raw encoding, `v` becomes a view of the mapped file
+     * (see interval_set.hh); otherwise, the intervals are decoded
+     * into `v`.
+     */
+    void get( size_t c, interval_set<int32_t> &v ) const;
+
+private:
+    struct contig {
+        std::string name;
+        size_t n;
+        cache_encoding_t encoding;
+        const int32_t *lefts;       // raw encoding
+        const int32_t *rights;
+        const uint64_t *blocks;     // delta encoding: offsets of the blocks in `data`
+        const uint8_t *data;
+    };
+    mapped_file file;
+    std::vector<contig> dir;
+};
+
+/**
+ * Return true iff the file `fname` starts as an interval cache.
+ */
+bool is_interval_cache( const char *fname );
+
+/**
+ * Write to `fname` the cache of the intervals in `B` with the given
+ * encoding; `B` maps the ID of each contig to the intervals of that
+ * contig, and `names[tid]` is the name of the contig with ID tid. All
+ * contigs in `names` are written, so that contig c of the cache is
+ * the contig with ID c. Return false on error.
+ */
+bool write_interval_cache( const char *fname,
+                           const std::map<int32_t, interval_set<int32_t> > &B,
+                           const std::vector<std::string> &names,
+                           cache_encoding_t encoding );
+
+#endif /* INTERVAL_CACHE_HH */
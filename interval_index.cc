@@ -0,0 +1,300 @@
+/****************************************************************************
+ *
+ * interval_index.cc - persistent index of a set of intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+/* Layout of the index file. All offsets are in bytes from the
+   beginning of the file, and all arrays start at a multiple of
+   ALIGN bytes.
+
+   +-------------------+
+   | index_header      |
+   +-------------------+
+   | arrays of contig 0|  lefts, rights, left tree, left ranks,
+   | arrays of contig 1|  right tree, right ranks
+   | ...               |
+   +-------------------+
+   | index_dir_entry   |  one for each contig; header.dir_offset
+   | ...               |  points here
+   +-------------------+
+   | contig names      |
+   +-------------------+
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <omp.h>
+#include "interval_index.hh"
+#include "bsearch_count.hh"
+
+static const char INDEX_MAGIC[8] = { 'I', 'N', 'T', 'X', 'I', 'D', 'X', '1' };
+static const uint64_t ALIGN = 64;
+
+struct index_header {
+    char magic[8];
+    uint64_t block;             // sorted_endpoints::BLOCK
+    uint64_t n_contigs;
+    uint64_t dir_offset;
+};
+
+struct index_dir_entry {
+    uint64_t name_offset;
+    uint64_t name_len;
+    uint64_t m;                 // number of intervals
+    uint64_t n_samples;         // number of samples of each tree
+    uint64_t lefts, rights;     // offsets of the sorted endpoints
+    uint64_t left_tree, left_rank;
+    uint64_t right_tree, right_rank;
+};
+
+size_t sorted_endpoints::count_le( int32_t x ) const
+{
+    /* Eytzinger search of the first sample > x; see
+       P.-V. Khuong, P. Morin, "Array Layouts for Comparison-Based
+       Searching", ACM J. Exp. Algorithmics 22, 2017 */
+    size_t i = 1;
+    while (i <= n_samples) {
+        __builtin_prefetch(tree + BLOCK*i);
+        i = 2*i + (tree[i] <= x);
+    }
+    i >>= __builtin_ffsll(~i);
+    // k is the number of samples <= x
+    const size_t k = (i == 0 ? n_samples : rank[i]);
+    if (k == 0)
+        return 0;
+    // v[start] <= x, and v[start + BLOCK] > x (if it exists)
+    const size_t start = (k-1)*BLOCK;
+    const size_t end = (start + BLOCK < n ? start + BLOCK : n);
+    size_t c = start;
+    for (size_t j=start; j<end; j++) {
+        c += (v[j] <= x);
+    }
+    return c;
+}
+
+size_t sorted_endpoints::count_lt( int32_t x ) const
+{
+    size_t i = 1;
+    while (i <= n_samples) {
+        __builtin_prefetch(tree + BLOCK*i);
+        i = 2*i + (tree[i] < x);
+    }
+    i >>= __builtin_ffsll(~i);
+    const size_t k = (i == 0 ? n_samples : rank[i]);
+    if (k == 0)
+        return 0;
+    const size_t start = (k-1)*BLOCK;
+    const size_t end = (start + BLOCK < n ? start + BLOCK : n);
+    size_t c = start;
+    for (size_t j=start; j<end; j++) {
+        c += (v[j] < x);
+    }
+    return c;
+}
+
+/**
+ * Fill the subtree of the Eytzinger tree rooted at node i with the
+ * samples of v, starting from sample k; return the next sample.
+ */
+static size_t build_tree( const std::vector<int32_t> &v,
+                          std::vector<int32_t> &tree,
+                          std::vector<uint32_t> &rank,
+                          size_t i, size_t k )
+{
+    const size_t n_samples = tree.size() - 1;
+    if (i <= n_samples) {
+        k = build_tree(v, tree, rank, 2*i, k);
+        tree[i] = v[k*sorted_endpoints::BLOCK];
+        rank[i] = k;
+        k = build_tree(v, tree, rank, 2*i + 1, k + 1);
+    }
+    return k;
+}
+
+/**
+ * Write `len` bytes from `buf` to `out`, padding the file to a
+ * multiple of ALIGN bytes; return the offset where the data start.
+ */
+static uint64_t write_aligned( std::ofstream &out, const void *buf, size_t len )
+{
+    static const char zeros[ALIGN] = { 0 };
+    const uint64_t ofs = out.tellp();
+    out.write(static_cast<const char*>(buf), len);
+    if (len % ALIGN)
+        out.write(zeros, ALIGN - len % ALIGN);
+    return ofs;
+}
+
+bool write_interval_index( const char *fname,
+                           const std::map<int32_t, interval_set<int32_t> > &B,
+                           const std::vector<std::string> &names )
+{
+    std::ofstream out(fname, std::ios::binary);
+    if (out.fail())
+        return false;
+
+    index_header hdr;
+    memcpy(hdr.magic, INDEX_MAGIC, sizeof(hdr.magic));
+    hdr.block = sorted_endpoints::BLOCK;
+    hdr.n_contigs = B.size();
+    hdr.dir_offset = 0;
+    write_aligned(out, &hdr, sizeof(hdr));
+
+    std::vector<index_dir_entry> dir;
+    std::string all_names;
+    for (auto c = B.begin(); c != B.end(); c++) {
+        const std::string &name = names.at(c->first);
+        std::vector<int32_t> lefts, rights;
+        sort_endpoints(c->second, lefts, rights);
+
+        const size_t m = lefts.size();
+        const size_t n_samples = (m + sorted_endpoints::BLOCK - 1) / sorted_endpoints::BLOCK;
+        std::vector<int32_t> left_tree(n_samples + 1), right_tree(n_samples + 1);
+        std::vector<uint32_t> left_rank(n_samples + 1), right_rank(n_samples + 1);
+        build_tree(lefts, left_tree, left_rank, 1, 0);
+        build_tree(rights, right_tree, right_rank, 1, 0);
+
+        index_dir_entry e;
+        e.name_offset = all_names.size();
+        e.name_len = name.size();
+        all_names += name;
+        e.m = m;
+        e.n_samples = n_samples;
+        e.lefts = write_aligned(out, lefts.data(), m * sizeof(int32_t));
+        e.rights = write_aligned(out, rights.data(), m * sizeof(int32_t));
+        e.left_tree = write_aligned(out, left_tree.data(), left_tree.size() * sizeof(int32_t));
+        e.left_rank = write_aligned(out, left_rank.data(), left_rank.size() * sizeof(uint32_t));
+        e.right_tree = write_aligned(out, right_tree.data(), right_tree.size() * sizeof(int32_t));
+        e.right_rank = write_aligned(out, right_rank.data(), right_rank.size() * sizeof(uint32_t));
+        dir.push_back(e);
+    }
+    hdr.dir_offset = write_aligned(out, dir.data(), dir.size() * sizeof(index_dir_entry));
+    const uint64_t names_offset = write_aligned(out, all_names.data(), all_names.size());
+    for (size_t i=0; i<dir.size(); i++) {
+        dir[i].name_offset += names_offset;
+    }
+    out.seekp(hdr.dir_offset);
+    out.write(reinterpret_cast<const char*>(dir.data()), dir.size() * sizeof(index_dir_entry));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.close();
+    return !out.fail();
+}
+
+/* Return true iff an array of `n` elements of `elem_size` bytes at
+   `offset` lies within a file of `size` bytes */
+static bool in_file( uint64_t offset, uint64_t n, uint64_t elem_size, uint64_t size )
+{
+    return (n <= size / elem_size && offset <= size - n * elem_size);
+}
+
+/* Return true iff the ranks of the samples of a tree are valid, so
+   that the searches do not go past the end of the endpoints */
+static bool valid_ranks( const uint32_t *rank, uint64_t n_samples )
+{
+    for (uint64_t i=1; i<=n_samples; i++) {
+        if (rank[i] >= n_samples)
+            return false;
+    }
+    return true;
+}
+
+bool interval_index::open( const char *fname )
+{
+    idx.clear();
+    if (!file.open(fname))
+        return false;
+
+    const char *base = file.data();
+    const uint64_t size = file.size();
+    index_header hdr;
+    if (size < sizeof(hdr))
+        return false;
+    memcpy(&hdr, base, sizeof(hdr));
+    if (memcmp(hdr.magic, INDEX_MAGIC, sizeof(hdr.magic)) ||
+        hdr.block != sorted_endpoints::BLOCK ||
+        !in_file(hdr.dir_offset, hdr.n_contigs, sizeof(index_dir_entry), size))
+        return false;
+
+    const index_dir_entry *dir = reinterpret_cast<const index_dir_entry*>(base + hdr.dir_offset);
+    for (uint64_t c=0; c<hdr.n_contigs; c++) {
+        const index_dir_entry &e = dir[c];
+        if (!in_file(e.name_offset, e.name_len, 1, size) ||
+            !in_file(e.lefts, e.m, sizeof(int32_t), size) ||
+            !in_file(e.rights, e.m, sizeof(int32_t), size) ||
+            e.n_samples != (e.m + sorted_endpoints::BLOCK - 1) / sorted_endpoints::BLOCK ||
+            !in_file(e.left_tree, e.n_samples + 1, sizeof(int32_t), size) ||
+            !in_file(e.left_rank, e.n_samples + 1, sizeof(uint32_t), size) ||
+            !in_file(e.right_tree, e.n_samples + 1, sizeof(int32_t), size) ||
+            !in_file(e.right_rank, e.n_samples + 1, sizeof(uint32_t), size) ||
+            !valid_ranks(reinterpret_cast<const uint32_t*>(base + e.left_rank), e.n_samples) ||
+            !valid_ranks(reinterpret_cast<const uint32_t*>(base + e.right_rank), e.n_samples))
+            return false;
+        contig_index ci;
+        ci.name.assign(base + e.name_offset, e.name_len);
+        ci.lefts.v = reinterpret_cast<const int32_t*>(base + e.lefts);
+        ci.lefts.n = e.m;
+        ci.lefts.tree = reinterpret_cast<const int32_t*>(base + e.left_tree);
+        ci.lefts.rank = reinterpret_cast<const uint32_t*>(base + e.left_rank);
+        ci.lefts.n_samples = e.n_samples;
+        ci.rights.v = reinterpret_cast<const int32_t*>(base + e.rights);
+        ci.rights.n = e.m;
+        ci.rights.tree = reinterpret_cast<const int32_t*>(base + e.right_tree);
+        ci.rights.rank = reinterpret_cast<const uint32_t*>(base + e.right_rank);
+        ci.rights.n_samples = e.n_samples;
+        idx.push_back(ci);
+    }
+    return true;
+}
+
+template<typename Count>
+static size_t count_index_impl( const std::vector<interval> &A,
+                                const contig_index &B,
+                                std::vector<Count> &counts )
+{
+    const size_t n = A.size();
+    size_t n_intersections = 0;
+
+    if (omp_get_level() == 0)
+        std::cout << "index_count... " << std::flush;
+
+    counts.resize(n);
+#pragma omp parallel for reduction(+:n_intersections)
+    for (size_t i=0; i<n; i++) {
+        counts[i] = B.lefts.count_le(A[i].right) - B.rights.count_lt(A[i].left);
+        n_intersections += counts[i];
+    }
+    return n_intersections;
+}
+
+size_t count_intersections_index( const std::vector<interval> &A,
+                                  const contig_index &B,
+                                  std::vector<int> &counts )
+{
+    return count_index_impl(A, B, counts);
+}
+
+size_t count_intersections_index( const std::vector<interval> &A,
+                                  const contig_index &B,
+                                  std::vector<int64_t> &counts )
+{
+    return count_index_impl(A, B, counts);
+}
@@ -0,0 +1,113 @@
+/****************************************************************************
+ *
+ * interval_index.hh - persistent index of a set of intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef INTERVAL_INDEX_HH
+#define INTERVAL_INDEX_HH
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "interval.hh"
+#include "interval_set.hh"
+#include "mapped_file.hh"
+
+/**
+ * Sorted array of endpoints, with a search tree to speed up the
+ * queries. The tree holds the samples v[0], v[BLOCK], v[2*BLOCK],
+ * ... in Eytzinger (BFS) order: the first levels of the tree stay in
+ * cache, and each search ends with a linear scan of a single block
+ * of BLOCK elements (one cache line).
+ */
+struct sorted_endpoints {
+    static const size_t BLOCK = 16;
+
+    const int32_t *v;           // sorted endpoints
+    size_t n;                   // number of endpoints
+    const int32_t *tree;        // samples in Eytzinger order (1-based)
+    const uint32_t *rank;       // rank[i] is the position of tree[i] among the samples
+    size_t n_samples;           // number of samples
+
+    /**
+     * Return the number of endpoints that are <= x
+     */
+    size_t count_le( int32_t x ) const;
+
+    /**
+     * Return the number of endpoints that are < x
+     */
+    size_t count_lt( int32_t x ) const;
+};
+
+/**
+ * Index of the intervals of one contig
+ */
+struct contig_index {
+    std::string name;
+    sorted_endpoints lefts;
+    sorted_endpoints rights;
+};
+
+/**
+ * Persistent index of the intervals of a set B, organized by
+ * contig. The index file is mapped in memory, so that it can be
+ * used without parsing or sorting anything.
+ */
+class interval_index {
+public:
+    /**
+     * Map the index file `fname` in memory; return false if the file
+     * can not be opened or is not a valid index.
+     */
+    bool open( const char *fname );
+
+    const std::vector<contig_index> &contigs( void ) const { return idx; }
+
+private:
+    mapped_file file;
+    std::vector<contig_index> idx;
+};
+
+/**
+ * Write to `fname` the index of the intervals in `B`; `B` maps the
+ * ID of each contig to the intervals of that contig, and
+ * `names[tid]` is the name of the contig with ID tid. Return false
+ * on error.
+ */
+bool write_interval_index( const char *fname,
+                           const std::map<int32_t, interval_set<int32_t> > &B,
+                           const std::vector<std::string> &names );
+
+/**
+ * Count how many intervals in the indexed contig `B` overlap each
+ * interval in `A`. The result is stored in the array `counts`; the
+ * return value is the total number of intersections. As in
+ * count_intersections_bsearch(), the counts must be 64 bits wide if
+ * needs_64bit_counts() is true.
+ */
+size_t count_intersections_index( const std::vector<interval> &A,
+                                  const contig_index &B,
+                                  std::vector<int> &counts );
+size_t count_intersections_index( const std::vector<interval> &A,
+                                  const contig_index &B,
+                                  std::vector<int64_t> &counts );
+
+#endif /* INTERVAL_INDEX_HH */
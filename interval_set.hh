@@ -0,0 +1,128 @@
+/****************************************************************************
+ *
+ * interval_set.hh - structure-of-arrays storage of intervals
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef INTERVAL_SET_HH
+#define INTERVAL_SET_HH
+
+#include <cstddef>
+#include <cassert>
+#include <vector>
+#include <utility>
+#include "interval.hh"
+
+/**
+ * A set of closed intervals [left, right], stored as two separate
+ * arrays of left and right endpoints (structure of arrays), so that
+ * the kernels only read the coordinates. The ID of an interval is
+ * its position in the set; no payload is stored (a user-defined
+ * payload can be kept in a separate array, indexed by ID). `Coord`
+ * is the type of the coordinates (e.g., int32_t or int64_t).
+ *
+ * A set can also be a read-only view of arrays owned by someone else
+ * (e.g., a mapped file, see interval_cache.hh); the kernels can use
+ * it as any other set, but it can not be modified.
+ */
+template<typename Coord>
+class interval_set {
+public:
+    typedef Coord coord_type;
+
+    interval_set(): view_lefts(NULL), view_rights(NULL), view_size(0) { }
+
+    /**
+     * Build a set from an array of intervals; the interval with
+     * index i in `v` gets ID i, irrespective of its `id` field.
+     */
+    explicit interval_set( const std::vector<interval> &v ):
+        lefts(v.size()),
+        rights(v.size()),
+        view_lefts(NULL),
+        view_rights(NULL),
+        view_size(0)
+    {
+        for (size_t i=0; i<v.size(); i++) {
+            lefts[i] = v[i].left;
+            rights[i] = v[i].right;
+        }
+    }
+
+    /**
+     * Build a read-only view of the `n` intervals whose endpoints are
+     * `l[0..n-1]` and `r[0..n-1]`; the arrays are not copied, and
+     * must outlive the set.
+     */
+    interval_set( const Coord *l, const Coord *r, size_t n ):
+        view_lefts(l),
+        view_rights(r),
+        view_size(n)
+    { }
+
+    bool is_view( void ) const { return view_lefts != NULL; }
+
+    size_t size( void ) const { return is_view() ? view_size : lefts.size(); }
+    bool empty( void ) const { return size() == 0; }
+
+    void reserve( size_t n ) { assert(!is_view()); lefts.reserve(n); rights.reserve(n); }
+    void resize( size_t n ) { assert(!is_view()); lefts.resize(n); rights.resize(n); }
+
+    void clear( void )
+    {
+        lefts.clear();
+        rights.clear();
+        view_lefts = view_rights = NULL;
+        view_size = 0;
+    }
+
+    void push_back( Coord l, Coord r )
+    {
+        assert(!is_view());
+        lefts.push_back(l);
+        rights.push_back(r);
+    }
+
+    void swap( interval_set &other )
+    {
+        lefts.swap(other.lefts);
+        rights.swap(other.rights);
+        std::swap(view_lefts, other.view_lefts);
+        std::swap(view_rights, other.view_rights);
+        std::swap(view_size, other.view_size);
+    }
+
+    Coord left( size_t i ) const { return left()[i]; }
+    Coord right( size_t i ) const { return right()[i]; }
+
+    // arrays of left and right endpoints
+    const Coord *left( void ) const { return is_view() ? view_lefts : lefts.data(); }
+    const Coord *right( void ) const { return is_view() ? view_rights : rights.data(); }
+    Coord *left( void ) { assert(!is_view()); return lefts.data(); }
+    Coord *right( void ) { assert(!is_view()); return rights.data(); }
+
+private:
+    std::vector<Coord> lefts;
+    std::vector<Coord> rights;
+    const Coord *view_lefts;    // not NULL iff the set is a view
+    const Coord *view_rights;
+    size_t view_size;
+};
+
+#endif /* INTERVAL_SET_HH */
@@ -29,8 +29,28 @@
 #include <cassert>
 #include <unistd.h>
 #include <cstring>
+#include <memory>
+#if _OPENMP
+#include <omp.h>
+#endif
 #include "interval.hh"
+#include "interval_set.hh"
 #include "count_intersections.hh"
+#include "bsearch_count.hh"
+#include "interval_index.hh"
+#include "interval_cache.hh"
+#include "bam_loader.hh"
+#include "stream_count.hh"
+#include "bed_reader.hh"
+#include "scheduler.hh"
+#include "depth.hh"
+#include "bin_count.hh"
+#include "external_count.hh"
+#include "enumerate.hh"
+#include "aggregate.hh"
+#include "generate.hh"
+#include "trace.hh"
+#include "workspace.hh"
 #include "utils.hh"
 
 extern "C" {
@@ -39,39 +59,161 @@ extern "C" {
 
 using namespace std;
 
+/* Algorithm used to count the intersections */
+enum engine_t {
+    ENGINE_SWEEP,       // sort all endpoints (count_intersections)
+    ENGINE_BSEARCH,     // sort the endpoints of B only (count_intersections_bsearch)
+    ENGINE_AUTO         // choose one of the above, based on the input sizes
+};
+
+/* ENGINE_AUTO uses the binary search engine when B has more than
+   BSEARCH_RATIO times the intervals of A */
+const size_t BSEARCH_RATIO = 16;
+
+/* Width of the IDs and counts used by the sweep engine: 32, 64, or 0
+   to choose 64 bits only when the input is too large for 32 bits */
+int index_bits = 0;
+
 void print_help(const char *exe_name)
 {
-    cerr << "Usage: " << exe_name << " [-N n_intervals] [-m BAM_file_name -d BED_file_name] [-n nreps]" << endl << endl
+    cerr << "Usage: " << exe_name << " [-N n_intervals [-g distribution] [-s seed]] [-m BAM_file_name -d BED_file_name] [-m BAM_file_name -w index_file_name] [-m BAM_file_name -k cache_file_name [-z]] [-i index_file_name -d BED_file_name] [-p n_threads] [-c] [-S] [-D] [-m BAM_file_name -W bin_width] [-P] [-Q] [-T] [-M mem_MB] [-o out_file_name] [-n nreps] [-e engine] [-b bits] [-F] [-H pages] [-t trace_file_name]" << endl << endl
          << "where:" << endl << endl
-         << "-m BAM_file_name" << endl
+         << "-m BAM_file_name\t(or the name of an interval cache written with -k)" << endl
          << "-d BED_file_name" << endl
+         << "-w index_file_name\twrite the index of the BAM file" << endl
+         << "-i index_file_name\tuse the index instead of the BAM file" << endl
+         << "-k cache_file_name\twrite the interval cache of the BAM file, which can then be" << endl
+         << "\t\tgiven to -m instead of the BAM file (except with -p, -S, -M and -Q)" << endl
+         << "-z\t\tdelta-encode the interval cache (smaller, but decoded on each load)" << endl
          << "-N n_intervals\tgenerate n_intervals random intervals (half A, half B)" << endl
+         << "-g distribution\tdistribution of the random intervals: uniform (default), exome," << endl
+         << "\t\theavy or nested (see generate.hh)" << endl
+         << "-s seed\t\tseed of the random intervals (default 1)" << endl
+         << "-p n_threads\tload a coordinate-sorted BAM file with n_threads decompression" << endl
+         << "\t\tthreads, while counting the intersections of the contigs already loaded" << endl
+         << "-c\t\tprocess small contigs concurrently, and large contigs one at a time" << endl
+         << "-S\t\tstreaming mode: sweep a coordinate-sorted BAM file and a sorted BED file" << endl
+         << "\t\twithout storing the alignments" << endl
+         << "-D\t\tcompute the depth of coverage of each base p in [L, R-1] of each target [L, R]" << endl
+         << "-W bin_width\tcount the alignments overlapping each bin of width bin_width (no BED file needed)" << endl
+         << "-P\t\tenumerate the pairs of overlapping target intervals and alignments" << endl
+         << "-Q\t\tsum the mapping qualities (MAPQ) of the alignments overlapping each target interval" << endl
+         << "-T\t\talso count the target intervals overlapping each alignment, and report the" << endl
+         << "\t\toff-target and multi-target alignments" << endl
+         << "-M mem_MB\tcount out of core, using about mem_MB megabytes for each slab of the" << endl
+         << "\t\tcoordinate axis; the spill files are created in $TMPDIR (default /tmp)" << endl
+         << "-o out_file_name\twrite the number of intersections of each target interval (streaming and" << endl
+         << "\t\tout-of-core modes), the pairs of overlapping intervals (pairs mode), the sum" << endl
+         << "\t\tof the MAPQ of each target interval (MAPQ mode)," << endl
+         << "\t\tthe depth of each base (depth mode), or the count of each bin (bin mode)" << endl
          << "-r nreps\tperforms nreps replications" << endl
+         << "-e engine\tsweep (default), bsearch or auto" << endl
+         << "-b bits\t\twidth of the IDs and counts: 32, 64 or auto (default;" << endl
+         << "\t\tuses 64 bits only when the input is too large for 32 bits)" << endl
+         << "-F\t\ttouch the temporary arrays of the kernels in parallel when they are allocated," << endl
+         << "\t\tso that their pages are spread across the NUMA nodes of the threads (bind" << endl
+         << "\t\tthe threads to cores with OMP_PROC_BIND and OMP_PLACES)" << endl
+         << "-H pages\tback the temporary arrays of the kernels with regular pages (default)," << endl
+         << "\t\ttransparent huge pages (thp) or reserved huge pages (hugetlb)" << endl
+         << "-t trace_file_name\twrite a trace of the kernels in the Chrome trace format" << endl
+         << "\t\t(requires a build with INSTRUMENT=1)" << endl
          << "-h\t\tThis help message" << endl << endl;
 }
 
 /**
- * Fill v with n random intervals
+ * Return true iff the intersections between `n` and `m` intervals
+ * must be counted with 64-bit IDs and counts, according to -b; exit
+ * if 32 bits were requested but are not enough.
  */
-void init( vector<interval> &v, int n )
+bool use_64bit_counts( size_t n, size_t m )
 {
-    v.clear();
-    for (int i=0; i<n; i++) {
-        interval intrv;
-        intrv.id = i;
-        intrv.left = randab(-100000, 100000);
-        intrv.right = intrv.left + randab(10,1000);
-        intrv.payload = 0;
-        v.push_back(intrv);
+    const bool wide = needs_64bit_counts(n, m);
+    if (index_bits == 32 && wide) {
+        cerr << "FATAL: " << n << " and " << m << " intervals require 64-bit counts" << endl;
+        exit(EXIT_FAILURE);
     }
+    return (index_bits == 64 || wide);
 }
 
 /**
- *
+ * Count how many intervals in `B` overlap each interval in `A` using
+ * the given engine, and return the total number of intersections;
+ * the temporary arrays are taken from `ws`, if not NULL.
+ */
+size_t count_with_engine( engine_t engine,
+                          const interval_set<int32_t> &A,
+                          const interval_set<int32_t> &B,
+                          count_workspace *ws = NULL )
+{
+    if (engine == ENGINE_AUTO)
+        engine = (B.size() > BSEARCH_RATIO * A.size() ? ENGINE_BSEARCH : ENGINE_SWEEP);
+
+    if (use_64bit_counts(A.size(), B.size())) {
+        vector<int64_t> counts;
+        if (engine == ENGINE_BSEARCH)
+            return count_intersections_bsearch(A, B, counts);
+        return count_intersections(A, B, counts, ws);
+    } else {
+        vector<int> counts;
+        if (engine == ENGINE_BSEARCH)
+            return count_intersections_bsearch(A, B, counts);
+        return count_intersections(A, B, counts, ws);
+    }
+}
+
+/* The interval cache given with -m, if any; the alignments of its
+   raw-encoded contigs are views of this mapping */
+interval_cache alignment_cache;
+
+/**
+ * Read the alignments from the interval cache `cache_file_name` (see
+ * read_bam()).
  */
-void test_with_bam_and_bed( const char* bam_file_name, const char *bed_file_name, int nreps )
+void read_cache( const char *cache_file_name,
+                 map<string, int32_t> &chrom_str2tid,
+                 map<int32_t, interval_set<int32_t> > &alignments )
 {
-    // READ BAM
+    TRACE_BEGIN("read_cache", "load");
+    if (!alignment_cache.open(cache_file_name)) {
+        cerr << "FATAL: Can not open interval cache \"" << cache_file_name << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    chrom_str2tid.clear();
+    alignments.clear();
+    size_t n_alignments = 0;
+    for (size_t tid = 0; tid < alignment_cache.n_contigs(); tid++) {
+        chrom_str2tid[alignment_cache.name(tid)] = tid;
+        if (alignment_cache.size(tid) > 0) {
+            alignment_cache.get(tid, alignments[tid]);
+            n_alignments += alignment_cache.size(tid);
+        }
+    }
+    TRACE_END();
+    cout << "Loaded " << n_alignments << " alignments from the cache" << endl;
+}
+
+/**
+ * Read the alignments from the BAM file `bam_file_name`. On exit,
+ * `chrom_str2tid` maps the name of each contig to its ID, and
+ * `alignments` maps the ID of each contig to its alignments. If
+ * `mapq` is not NULL, it maps the ID of each contig to the mapping
+ * quality of each alignment. `bam_file_name` can also be an interval
+ * cache (see build_cache()), which does not hold the MAPQ.
+ */
+void read_bam( const char *bam_file_name,
+               map<string, int32_t> &chrom_str2tid,
+               map<int32_t, interval_set<int32_t> > &alignments,
+               map<int32_t, vector<int64_t> > *mapq = NULL )
+{
+    if (is_interval_cache(bam_file_name)) {
+        if (mapq != NULL) {
+            cerr << "FATAL: The interval cache \"" << bam_file_name << "\" does not hold the MAPQ of the alignments" << endl;
+            exit(EXIT_FAILURE);
+        }
+        read_cache(bam_file_name, chrom_str2tid, alignments);
+        return;
+    }
+    TRACE_BEGIN("read_bam", "load");
     samFile *fp_in = hts_open(bam_file_name,"r"); // open bam file
     if (fp_in == NULL) {
         cerr << "FATAL: Can not open BAM file \"" << bam_file_name << "\"" << endl;
@@ -81,120 +223,879 @@ void test_with_bam_and_bed( const char* bam_file_name, const char *bed_file_name
     bam1_t *aln = bam_init1();                  // initialize an alignment
 
     // get contig names from bam header
-    map<string, int32_t> chrom_str2tid;
+    chrom_str2tid.clear();
     for (int32_t tid = 0; tid < bamHdr->n_targets; tid++) {
         chrom_str2tid[bamHdr->target_name[tid]] = tid;
     }
 
     // get alignment intervals from bam
-    map<int32_t, vector<interval> > alignments;
+    alignments.clear();
+    if (mapq != NULL)
+        mapq->clear();
     while (sam_read1(fp_in,bamHdr,aln) > 0) {
-        interval i;
-        i.id = 0;
-        i.left = aln->core.pos + 1;
-        i.right = aln->core.pos + aln->core.l_qseq;
-        i.payload = 0;
-        alignments[aln->core.tid].push_back(i);
+        alignments[aln->core.tid].push_back(aln->core.pos + 1, aln->core.pos + aln->core.l_qseq);
+        if (mapq != NULL)
+            (*mapq)[aln->core.tid].push_back(aln->core.qual);
     }
     bam_destroy1(aln);
     sam_close(fp_in);
+    TRACE_END();
     cout << "Loaded " << alignments.size() << " alignments" << endl;
+}
 
-    // get target intervals from bed
+/**
+ * Read the target intervals from the BED file `bed_file_name`;
+ * `chrom_str2tid` maps the name of each contig to its ID. On exit,
+ * `targets` maps the ID of each contig to its target intervals; the
+ * intervals of each contig are numbered 0, 1, ...
+ */
+void read_bed( const char *bed_file_name,
+               const map<string, int32_t> &chrom_str2tid,
+               map<int32_t, vector<interval> > &targets )
+{
+    vector<string> names(chrom_str2tid.size());
+    for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+        names[contig->second] = contig->first;
+    }
+    string error;
+    TRACE_BEGIN("read_bed", "load");
+    if (!read_bed_file(bed_file_name, contig_table(names), targets, error)) {
+        cerr << "FATAL: Can not read BED file \"" << bed_file_name << "\": " << error << endl;
+        exit(EXIT_FAILURE);
+    }
+    TRACE_END();
+    cout << "Loaded " << targets.size() << " target intervals" << endl;
+}
+
+/**
+ * Build the index of the alignments in the BAM file `bam_file_name`,
+ * and write it to `index_file_name`.
+ */
+void build_index( const char *bam_file_name, const char *index_file_name )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+
+    read_bam(bam_file_name, chrom_str2tid, alignments);
+    vector<string> names(chrom_str2tid.size());
+    for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+        names[contig->second] = contig->first;
+    }
+    const double tstart = now();
+    if (!write_interval_index(index_file_name, alignments, names)) {
+        cerr << "FATAL: Can not write index file \"" << index_file_name << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    cout << "Index written to \"" << index_file_name << "\" in " << now() - tstart << " s" << endl;
+}
+
+/**
+ * Write the interval cache of the alignments in the BAM file
+ * `bam_file_name` to `cache_file_name`, with the given encoding.
+ */
+void build_cache( const char *bam_file_name, const char *cache_file_name, cache_encoding_t encoding )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+
+    read_bam(bam_file_name, chrom_str2tid, alignments);
+    vector<string> names(chrom_str2tid.size());
+    for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+        names[contig->second] = contig->first;
+    }
+    const double tstart = now();
+    if (!write_interval_cache(cache_file_name, alignments, names, encoding)) {
+        cerr << "FATAL: Can not write interval cache \"" << cache_file_name << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    cout << "Interval cache written to \"" << cache_file_name << "\" in " << now() - tstart << " s" << endl;
+}
+
+/**
+ * Count the intersections between the target intervals in the BED
+ * file `bed_file_name` and the alignments in the index file
+ * `index_file_name`.
+ */
+void test_with_index_and_bed( const char *index_file_name, const char *bed_file_name, int nreps )
+{
+    const double tstart = now();
+    interval_index index;
+    if (!index.open(index_file_name)) {
+        cerr << "FATAL: Can not open index file \"" << index_file_name << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    cout << "Index loaded in " << now() - tstart << " s" << endl;
+
+    const vector<contig_index> &contigs = index.contigs();
+    map<string, int32_t> chrom_str2tid;
+    for (size_t c = 0; c < contigs.size(); c++) {
+        chrom_str2tid[contigs[c].name] = c;
+    }
+    map<int32_t, vector<interval> > targets;
+    read_bed(bed_file_name, chrom_str2tid, targets);
+
+    double intersection_time = 0;
+    for (int r = 0; r<nreps; r++) {
+        cout << "**" << endl
+             << "** Replication " << r+1 << " of " << nreps << endl
+             << "**" << endl;
+        for (auto t = targets.begin(); t != targets.end(); t++) {
+            const contig_index &contig = contigs[t->first];
+            cout << "Contig \"" <<
+                contig.name << "\" has " <<
+                contig.lefts.n << " alignments and " <<
+                t->second.size() << " target intervals... ";
+            const double tstart = now();
+            size_t n_intersections;
+            if (use_64bit_counts(t->second.size(), contig.lefts.n)) {
+                vector<int64_t> counts;
+                n_intersections = count_intersections_index(t->second, contig, counts);
+            } else {
+                vector<int> counts;
+                n_intersections = count_intersections_index(t->second, contig, counts);
+            }
+            const double elapsed = now() - tstart;
+            cout << n_intersections << " intersections" << endl;
+            intersection_time += elapsed;
+        }
+    }
+    cout << "**" << endl
+         << "** Average intersection time (s) " << intersection_time/nreps << endl
+         << "**" << endl << endl;
+}
+
+/**
+ * Count the intersections between the target intervals `targets` and
+ * the alignments `alignments` of the contig `name`, and write a
+ * summary to `out`; return the time spent counting. The temporary
+ * arrays are taken from `ws`, if not NULL.
+ */
+double count_contig( const string &name,
+                     const interval_set<int32_t> &alignments,
+                     const vector<interval> &targets,
+                     engine_t engine,
+                     count_workspace *ws = NULL,
+                     ostream &out = cout )
+{
+    out << "Contig \"" <<
+        name << "\" has " <<
+        alignments.size() << " alignments and " <<
+        targets.size() << " target intervals... ";
+
+    // the kernels only read the coordinates of the target intervals
+    // (per-base depths are computed by test_depth())
+    const interval_set<int32_t> windows(targets);
+    TRACE_BEGIN_STR(name, "contig");
+    TRACE_BYTES(2*(windows.size() + alignments.size())*sizeof(int32_t));
+    const double tstart = now();
+    const size_t n_intersections = count_with_engine(engine, windows, alignments, ws);
+    const double elapsed = now() - tstart;
+    TRACE_END();
+    out << n_intersections << " intersections" << endl;
+    return elapsed;
+}
+
+/**
+ * Same as the loop over the contigs in test_with_bam_and_bed(), where
+ * the contigs are handed to the scheduler: contigs with few endpoints
+ * are processed concurrently, each one by a single thread, while
+ * large contigs are processed one at a time by all threads. The
+ * output of each contig is printed in the usual order at the
+ * end. Return the wall-clock time spent counting.
+ */
+double count_contigs_concurrently( const map<string, int32_t> &chrom_str2tid,
+                                   const map<int32_t, interval_set<int32_t> > &alignments,
+                                   const map<int32_t, vector<interval> > &targets,
+                                   engine_t engine )
+{
+    vector<job> jobs;
+    vector<ostringstream> out(chrom_str2tid.size());
+    size_t c = 0;
+    for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++, c++) {
+        const int32_t tid = contig->second;
+        if (alignments.count(tid) && targets.count(tid)) {
+            const string &name = contig->first;
+            const interval_set<int32_t> &aln = alignments.at(tid);
+            const vector<interval> &tgt = targets.at(tid);
+            ostringstream &os = out[c];
+            job j;
+            j.size = 2*(aln.size() + tgt.size());
+            j.run = [&name, &aln, &tgt, &os, engine]() {
+                count_contig(name, aln, tgt, engine, NULL, os);
+            };
+            jobs.push_back(j);
+        }
+    }
+    const double tstart = now();
+    run_jobs(jobs);
+    const double elapsed = now() - tstart;
+    for (size_t i=0; i<out.size(); i++) {
+        cout << out[i].str();
+    }
+    return elapsed;
+}
+
+/**
+ *
+ */
+void test_with_bam_and_bed( const char* bam_file_name, const char *bed_file_name, int nreps, engine_t engine, bool concurrent )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
     map<int32_t, vector<interval> > targets;
-    ifstream bed;
-    bed.open(bed_file_name);
-    if (bed.fail()) {
-        cerr << "FATAL: Can not open BED file \"" << bed_file_name << "\"" << endl;
+
+    const double tstart = now();
+    read_bam(bam_file_name, chrom_str2tid, alignments);
+    read_bed(bed_file_name, chrom_str2tid, targets);
+
+    // the temporary arrays are reused across contigs and replications
+    count_workspace ws;
+    double intersection_time = 0;
+    for (int r = 0; r<nreps; r++) {
+        cout << "**" << endl
+             << "** Replication " << r+1 << " of " << nreps << endl
+             << "**" << endl;
+        if (concurrent) {
+            intersection_time += count_contigs_concurrently(chrom_str2tid, alignments, targets, engine);
+        } else {
+            for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+                const int32_t tid = contig->second;
+                if (alignments.count(tid) && targets.count(tid)) {
+                    intersection_time += count_contig(contig->first, alignments.at(tid), targets.at(tid), engine, &ws);
+                }
+            }
+        }
+    }
+    cout << "**" << endl
+	 << "** Average intersection time (s) " << intersection_time/nreps << endl
+	 << "** Workspace high-water mark (MB) " << ws.high_water_mark() / (1024.0*1024.0) << endl
+	 << "** End-to-end time (s) " << now() - tstart << endl
+	 << "**" << endl << endl;
+}
+
+/**
+ * Same as test_with_bam_and_bed(), where the BAM file must be sorted
+ * by coordinate. The alignments are loaded in the background by
+ * `n_threads` decompression threads, and each contig is processed
+ * as soon as all its alignments are available, while the next
+ * contig is being loaded.
+ */
+void test_with_bam_and_bed_pipelined( const char* bam_file_name, const char *bed_file_name, int nreps, engine_t engine, int n_threads )
+{
+    const double tstart = now();
+    bam_loader loader;
+    if (!loader.open(bam_file_name, n_threads)) {
+        cerr << "FATAL: Can not open BAM file \"" << bam_file_name << "\"" << endl;
         exit(EXIT_FAILURE);
     }
-    string chrom_str;
-    int32_t start, end;
-    string line;
-    while (getline(bed, line)) {
-        istringstream ss(line);
-        ss >> chrom_str >> start >> end;
-        int32_t tid = chrom_str2tid.at(chrom_str2tid.count(chrom_str) ? chrom_str : chrom_str.substr(3));
-        interval i;
-        i.id = 0;
-        i.left = start;
-        i.right = end;
-        i.payload = 0;
-        targets[tid].push_back(i);
+    const vector<string> &names = loader.contig_names();
+    map<string, int32_t> chrom_str2tid;
+    for (size_t tid = 0; tid < names.size(); tid++) {
+        chrom_str2tid[names[tid]] = tid;
     }
-    cout << "Loaded " << targets.size() << " target intervals" << endl;
+    map<int32_t, vector<interval> > targets;
+    read_bed(bed_file_name, chrom_str2tid, targets);
 
+    // the first replication is overlapped with loading
+    map<int32_t, interval_set<int32_t> > alignments;
+    count_workspace ws;
     double intersection_time = 0;
+    int32_t tid;
+    interval_set<int32_t> aln;
+    cout << "**" << endl
+         << "** Replication 1 of " << nreps << endl
+         << "**" << endl;
+    loader.start();
+    while (loader.next(tid, aln)) {
+        if (targets.count(tid)) {
+            intersection_time += count_contig(names[tid], aln, targets.at(tid), engine, &ws);
+        }
+        alignments[tid].swap(aln);
+    }
+    if (loader.failed()) {
+        cerr << "FATAL: BAM file \"" << bam_file_name << "\" is not sorted by coordinate" << endl;
+        exit(EXIT_FAILURE);
+    }
+    cout << "Loaded " << alignments.size() << " alignments" << endl;
+
+    for (int r = 1; r<nreps; r++) {
+        cout << "**" << endl
+             << "** Replication " << r+1 << " of " << nreps << endl
+             << "**" << endl;
+        for (auto a = alignments.begin(); a != alignments.end(); a++) {
+            if (targets.count(a->first)) {
+                intersection_time += count_contig(names[a->first], a->second, targets.at(a->first), engine, &ws);
+            }
+        }
+    }
+    cout << "**" << endl
+	 << "** Average intersection time (s) " << intersection_time/nreps << endl
+	 << "** Workspace high-water mark (MB) " << ws.high_water_mark() / (1024.0*1024.0) << endl
+	 << "** End-to-end time (s) " << now() - tstart << endl
+	 << "**" << endl << endl;
+}
+
+/**
+ * Compute the depth of coverage of each base of the target intervals
+ * in the BED file `bed_file_name`, using the alignments in the BAM
+ * file `bam_file_name`. If `out_file_name` is not NULL, the depth of
+ * each base is written to that file (during the first replication).
+ */
+void test_depth( const char* bam_file_name, const char *bed_file_name, int nreps, const char *out_file_name )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+    map<int32_t, vector<interval> > targets;
+
+    const double tstart = now();
+    read_bam(bam_file_name, chrom_str2tid, alignments);
+    read_bed(bed_file_name, chrom_str2tid, targets);
+
+    ofstream out;
+    if (out_file_name != NULL) {
+        out.open(out_file_name);
+        if (out.fail()) {
+            cerr << "FATAL: Can not open output file \"" << out_file_name << "\"" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    double depth_time = 0;
     for (int r = 0; r<nreps; r++) {
         cout << "**" << endl
              << "** Replication " << r+1 << " of " << nreps << endl
              << "**" << endl;
         for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
             const int32_t tid = contig->second;
-            // cout << contig << ":" << tid << endl;
             if (alignments.count(tid) && targets.count(tid)) {
+                const vector<interval> &tgt = targets.at(tid);
                 cout << "Contig \"" <<
                     contig->first << "\" has " <<
                     alignments.at(tid).size() << " alignments and " <<
-                    targets.at(tid).size() << " target intervals... ";
-
-                // split target intervals into 1-base windows
-                vector<interval> windows;
-                int id = 0;
-                for (auto t = targets.at(tid).begin(); t != targets.at(tid).end(); t++) {
-#if 0
-                    // The following loop replaces an interval [a, b] with
-                    // a set of non-overlapping unitary intervals [a,
-                    // a+1], [a+1, a+2], ... [b-1, b]
-                    for (int32_t pos = t->left; pos < t->right; pos++) {
-                        interval i;
-                        i.id = id++;
-                        i.left = pos;
-                        i.right = pos + 1;
-                        i.payload = 0;
-                        windows.push_back(i);
+                    tgt.size() << " target intervals... ";
+                vector<size_t> offsets;
+                vector<int> depth;
+                const double tstart = now();
+                const size_t total = depth_of_coverage(interval_set<int32_t>(tgt), alignments.at(tid), offsets, depth);
+                depth_time += now() - tstart;
+                cout << depth.size() << " bases, total depth " << total << endl;
+                if (r == 0 && out.is_open()) {
+                    for (size_t i=0; i<tgt.size(); i++) {
+                        for (size_t p=offsets[i]; p<offsets[i+1]; p++) {
+                            out << contig->first << "\t" << tgt[i].left + int32_t(p - offsets[i]) << "\t" << depth[p] << "\n";
+                        }
                     }
-#else
-                    interval i;
-                    i.id = id++;
-                    i.left = t->left;
-                    i.right = t->right;
-                    i.payload = 0;
-                    windows.push_back(i);
-#endif
                 }
-                vector<int> counts;
+            }
+        }
+    }
+    cout << "**" << endl
+	 << "** Average depth time (s) " << depth_time/nreps << endl
+	 << "** End-to-end time (s) " << now() - tstart << endl
+	 << "**" << endl << endl;
+}
+
+/**
+ * Count the intersections between `targets` and `alignments` in both
+ * directions with a single sort, and store in `off_target` the
+ * number of alignments that do not overlap any target interval, and
+ * in `multi_target` the number of alignments that overlap more than
+ * one target interval. Return the number of intersections.
+ */
+template<typename Count>
+size_t count_both_ways( const interval_set<int32_t> &targets,
+                        const interval_set<int32_t> &alignments,
+                        size_t &off_target,
+                        size_t &multi_target,
+                        count_workspace *ws )
+{
+    vector<Count> per_target, per_alignment;
+    const size_t n_intersections = count_intersections_symmetric(targets, alignments, per_target, per_alignment, ws);
+    off_target = multi_target = 0;
+    for (size_t j=0; j<per_alignment.size(); j++) {
+        off_target += (per_alignment[j] == 0);
+        multi_target += (per_alignment[j] > 1);
+    }
+    return n_intersections;
+}
+
+/**
+ * Count the alignments that overlap each target interval and the
+ * target intervals that overlap each alignment, and report the number
+ * of off-target and multi-target alignments of each contig.
+ */
+void test_symmetric( const char* bam_file_name, const char *bed_file_name, int nreps )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+    map<int32_t, vector<interval> > targets;
+
+    const double tstart = now();
+    read_bam(bam_file_name, chrom_str2tid, alignments);
+    read_bed(bed_file_name, chrom_str2tid, targets);
+
+    count_workspace ws;
+    double intersection_time = 0;
+    size_t total_alignments = 0, total_off_target = 0;
+    for (int r = 0; r<nreps; r++) {
+        cout << "**" << endl
+             << "** Replication " << r+1 << " of " << nreps << endl
+             << "**" << endl;
+        total_alignments = total_off_target = 0;
+        for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+            const int32_t tid = contig->second;
+            if (alignments.count(tid) && targets.count(tid)) {
+                const interval_set<int32_t> &aln = alignments.at(tid);
+                const interval_set<int32_t> windows(targets.at(tid));
+                cout << "Contig \"" <<
+                    contig->first << "\" has " <<
+                    aln.size() << " alignments and " <<
+                    windows.size() << " target intervals... ";
+                size_t off_target, multi_target, n_intersections;
                 const double tstart = now();
-                const int n_intersections = count_intersections(windows, alignments.at(tid), counts);
-                const double elapsed = now() - tstart;
-                cout << n_intersections << " intersections" << endl;
-                intersection_time += elapsed;
+                if (use_64bit_counts(windows.size(), aln.size()))
+                    n_intersections = count_both_ways<int64_t>(windows, aln, off_target, multi_target, &ws);
+                else
+                    n_intersections = count_both_ways<int>(windows, aln, off_target, multi_target, &ws);
+                intersection_time += now() - tstart;
+                cout << n_intersections << " intersections, "
+                     << off_target << " off-target and "
+                     << multi_target << " multi-target alignments" << endl;
+                total_alignments += aln.size();
+                total_off_target += off_target;
+            } else if (alignments.count(tid)) {
+                // no targets: all the alignments of the contig are off-target
+                const size_t n_aln = alignments.at(tid).size();
+                cout << "Contig \"" <<
+                    contig->first << "\" has " <<
+                    n_aln << " alignments and no target intervals... "
+                     << n_aln << " off-target alignments" << endl;
+                total_alignments += n_aln;
+                total_off_target += n_aln;
             }
         }
     }
     cout << "**" << endl
+	 << "** Off-target rate " << (total_alignments > 0 ? double(total_off_target) / total_alignments : 0.0) << endl
 	 << "** Average intersection time (s) " << intersection_time/nreps << endl
+	 << "** End-to-end time (s) " << now() - tstart << endl
+	 << "**" << endl << endl;
+}
+
+/**
+ * Compute, for each target interval, the sum of the mapping qualities
+ * (MAPQ) of the alignments that overlap it, with the same prefix-sum
+ * technique used to count the intersections. If `out_file_name` is
+ * not NULL, the sum of each target interval is written to that file
+ * (during the first replication).
+ */
+void test_mapq( const char* bam_file_name, const char *bed_file_name, int nreps, const char *out_file_name )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+    map<int32_t, vector<int64_t> > mapq;
+    map<int32_t, vector<interval> > targets;
+
+    const double tstart = now();
+    read_bam(bam_file_name, chrom_str2tid, alignments, &mapq);
+    read_bed(bed_file_name, chrom_str2tid, targets);
+
+    ofstream out;
+    if (out_file_name != NULL) {
+        out.open(out_file_name);
+        if (out.fail()) {
+            cerr << "FATAL: Can not open output file \"" << out_file_name << "\"" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    count_workspace ws;
+    double mapq_time = 0;
+    for (int r = 0; r<nreps; r++) {
+        cout << "**" << endl
+             << "** Replication " << r+1 << " of " << nreps << endl
+             << "**" << endl;
+        for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+            const int32_t tid = contig->second;
+            if (alignments.count(tid) && targets.count(tid)) {
+                const vector<interval> &tgt = targets.at(tid);
+                cout << "Contig \"" <<
+                    contig->first << "\" has " <<
+                    alignments.at(tid).size() << " alignments and " <<
+                    tgt.size() << " target intervals... ";
+                vector<int64_t> sums;
+                const double tstart = now();
+                const int64_t total = aggregate_intersections<int32_t, sum_op<int64_t> >(interval_set<int32_t>(tgt), alignments.at(tid), mapq.at(tid), sums, &ws);
+                mapq_time += now() - tstart;
+                cout << "total MAPQ " << total << endl;
+                if (r == 0 && out.is_open()) {
+                    for (size_t i=0; i<tgt.size(); i++) {
+                        out << contig->first << "\t" << tgt[i].left << "\t" << tgt[i].right << "\t" << sums[i] << "\n";
+                    }
+                }
+            }
+        }
+    }
+    cout << "**" << endl
+	 << "** Average MAPQ aggregation time (s) " << mapq_time/nreps << endl
+	 << "** End-to-end time (s) " << now() - tstart << endl
 	 << "**" << endl << endl;
 }
 
+/**
+ * Enumerate the pairs of overlapping target intervals and alignments;
+ * if `out_file_name` is not NULL, the pairs are written to that file
+ * (during the first replication), one per line, with the contig and
+ * the endpoints of the target interval followed by those of the
+ * alignment. The pairs of each contig are produced and written in
+ * batches, so they do not need to fit in memory at once.
+ */
+void test_pairs( const char* bam_file_name, const char *bed_file_name, int nreps, const char *out_file_name )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+    map<int32_t, vector<interval> > targets;
+
+    const double tstart = now();
+    read_bam(bam_file_name, chrom_str2tid, alignments);
+    read_bed(bed_file_name, chrom_str2tid, targets);
+
+    ofstream out;
+    if (out_file_name != NULL) {
+        out.open(out_file_name);
+        if (out.fail()) {
+            cerr << "FATAL: Can not open output file \"" << out_file_name << "\"" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    count_workspace ws;
+    double pairs_time = 0;
+    for (int r = 0; r<nreps; r++) {
+        cout << "**" << endl
+             << "** Replication " << r+1 << " of " << nreps << endl
+             << "**" << endl;
+        for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+            const int32_t tid = contig->second;
+            if (alignments.count(tid) && targets.count(tid)) {
+                const string &name = contig->first;
+                const interval_set<int32_t> &aln = alignments.at(tid);
+                const interval_set<int32_t> windows(targets.at(tid));
+                cout << "Contig \"" <<
+                    name << "\" has " <<
+                    aln.size() << " alignments and " <<
+                    windows.size() << " target intervals... ";
+                const bool write = (r == 0 && out.is_open());
+                const double tstart = now();
+                const size_t n_pairs = enumerate_intersections(windows, aln, [&](const overlap *pairs, size_t n) {
+                        for (size_t k=0; write && k<n; k++) {
+                            const size_t a = pairs[k].a, b = pairs[k].b;
+                            out << name << "\t" << windows.left(a) << "\t" << windows.right(a) << "\t"
+                                << name << "\t" << aln.left(b) << "\t" << aln.right(b) << "\n";
+                        }
+                    }, PAIR_BATCH_SIZE, &ws);
+                pairs_time += now() - tstart;
+                cout << n_pairs << " pairs" << endl;
+            }
+        }
+    }
+    cout << "**" << endl
+	 << "** Average enumeration time (s) " << pairs_time/nreps << endl
+	 << "** End-to-end time (s) " << now() - tstart << endl
+	 << "**" << endl << endl;
+}
+
+/**
+ * Count the alignments in the BAM file `bam_file_name` that overlap
+ * each bin of width `width` of each contig. If `out_file_name` is not
+ * NULL, the count of each bin is written to that file (during the
+ * first replication).
+ */
+void test_bins( const char* bam_file_name, int32_t width, int nreps, const char *out_file_name )
+{
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+
+    const double tstart = now();
+    read_bam(bam_file_name, chrom_str2tid, alignments);
+
+    ofstream out;
+    if (out_file_name != NULL) {
+        out.open(out_file_name);
+        if (out.fail()) {
+            cerr << "FATAL: Can not open output file \"" << out_file_name << "\"" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    double bin_time = 0;
+    for (int r = 0; r<nreps; r++) {
+        cout << "**" << endl
+             << "** Replication " << r+1 << " of " << nreps << endl
+             << "**" << endl;
+        for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+            const int32_t tid = contig->second;
+            if (alignments.count(tid)) {
+                cout << "Contig \"" <<
+                    contig->first << "\" has " <<
+                    alignments.at(tid).size() << " alignments... ";
+                vector<int> counts;
+                const double tstart = now();
+                const size_t total = count_bins(alignments.at(tid), width, counts);
+                bin_time += now() - tstart;
+                cout << counts.size() << " bins, " << total << " intersections" << endl;
+                if (r == 0 && out.is_open()) {
+                    for (size_t k=0; k<counts.size(); k++) {
+                        out << contig->first << "\t" << k*width << "\t" << (k+1)*width << "\t" << counts[k] << "\n";
+                    }
+                }
+            }
+        }
+    }
+    cout << "**" << endl
+	 << "** Average bin count time (s) " << bin_time/nreps << endl
+	 << "** End-to-end time (s) " << now() - tstart << endl
+	 << "**" << endl << endl;
+}
+
+/**
+ * Count the intersections between the target intervals in the BED
+ * file `bed_file_name` and the alignments in the BAM file
+ * `bam_file_name` with a single sweep of both files. The BAM file
+ * must be sorted by coordinate, and the target intervals of each
+ * contig must be sorted by left endpoint. The alignments are not
+ * stored, so the memory usage does not depend on the size of the BAM
+ * file. If `out_file_name` is not NULL, the number of intersections
+ * of each target interval is written to that file as soon as it is
+ * known.
+ */
+void test_streaming( const char *bam_file_name, const char *bed_file_name, const char *out_file_name )
+{
+    const double tstart = now();
+    samFile *fp_in = hts_open(bam_file_name,"r");
+    if (fp_in == NULL) {
+        cerr << "FATAL: Can not open BAM file \"" << bam_file_name << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    bam_hdr_t *bamHdr = sam_hdr_read(fp_in);
+    bam1_t *aln = bam_init1();
+
+    map<string, int32_t> chrom_str2tid;
+    for (int32_t tid = 0; tid < bamHdr->n_targets; tid++) {
+        chrom_str2tid[bamHdr->target_name[tid]] = tid;
+    }
+
+    map<int32_t, vector<interval> > targets;
+    read_bed(bed_file_name, chrom_str2tid, targets);
+    for (auto t = targets.begin(); t != targets.end(); t++) {
+        if (!sorted_by_left(t->second)) {
+            cerr << "FATAL: The target intervals of contig \"" << bamHdr->target_name[t->first] << "\" are not sorted" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ofstream out;
+    if (out_file_name != NULL) {
+        out.open(out_file_name);
+        if (out.fail()) {
+            cerr << "FATAL: Can not open output file \"" << out_file_name << "\"" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    vector<bool> seen(bamHdr->n_targets, false);
+    unique_ptr<stream_counter> counter;
+    int32_t cur_tid = -1;
+    int64_t cur_pos = 0;
+    size_t n_alignments = 0;
+    bool more = true;
+    while (more) {
+        more = (sam_read1(fp_in,bamHdr,aln) > 0);
+        const int32_t tid = (more ? aln->core.tid : -1);
+        if (!more || tid != cur_tid) {
+            if (counter) {
+                counter->finish();
+                cout << "Contig \"" <<
+                    bamHdr->target_name[cur_tid] << "\" has " <<
+                    n_alignments << " alignments and " <<
+                    targets.at(cur_tid).size() << " target intervals... " <<
+                    counter->n_intersections() << " intersections" << endl;
+                counter.reset();
+            }
+            if (tid >= 0) {
+                if (seen[tid]) {
+                    cerr << "FATAL: BAM file \"" << bam_file_name << "\" is not sorted by coordinate" << endl;
+                    exit(EXIT_FAILURE);
+                }
+                seen[tid] = true;
+                if (targets.count(tid)) {
+                    const vector<interval> &t = targets.at(tid);
+                    const char *name = bamHdr->target_name[tid];
+                    counter.reset(new stream_counter(t, [&out, &t, name](size_t i, int cnt) {
+                                if (out.is_open())
+                                    out << name << "\t" << t[i].left << "\t" << t[i].right << "\t" << cnt << "\n";
+                            }));
+                }
+            }
+            cur_tid = tid;
+            cur_pos = 0;
+            n_alignments = 0;
+        }
+        if (counter) {
+            if (aln->core.pos < cur_pos) {
+                cerr << "FATAL: BAM file \"" << bam_file_name << "\" is not sorted by coordinate" << endl;
+                exit(EXIT_FAILURE);
+            }
+            cur_pos = aln->core.pos;
+            counter->add(aln->core.pos + 1, aln->core.pos + aln->core.l_qseq);
+            n_alignments++;
+        }
+    }
+    // the targets of the contigs without alignments have no intersections
+    for (auto t = targets.begin(); t != targets.end(); t++) {
+        if (seen[t->first])
+            continue;
+        const char *name = bamHdr->target_name[t->first];
+        cout << "Contig \"" << name << "\" has 0 alignments and " <<
+            t->second.size() << " target intervals... 0 intersections" << endl;
+        if (out.is_open()) {
+            for (auto i = t->second.begin(); i != t->second.end(); i++) {
+                out << name << "\t" << i->left << "\t" << i->right << "\t" << 0 << "\n";
+            }
+        }
+    }
+    bam_destroy1(aln);
+    sam_close(fp_in);
+    cout << "**" << endl
+         << "** Streaming time (s) " << now() - tstart << endl
+         << "**" << endl << endl;
+}
+
+/**
+ * Count the intersections between the target intervals in the BED
+ * file `bed_file_name` and the alignments in the BAM file
+ * `bam_file_name` out of core, using about `mem_budget` bytes for
+ * each slab of the coordinate axis (see external_count.hh). The BAM
+ * file does not need to be sorted. The contigs are laid out one after
+ * the other on a single 64-bit axis, so that all contigs are handled
+ * by the same sequence of slabs. The spill files are created in
+ * $TMPDIR (/tmp by default). If `out_file_name` is not NULL, the
+ * number of intersections of each target interval is written to that
+ * file.
+ */
+void test_out_of_core( const char *bam_file_name, const char *bed_file_name, size_t mem_budget, const char *out_file_name )
+{
+    const double tstart = now();
+    samFile *fp_in = hts_open(bam_file_name,"r");
+    if (fp_in == NULL) {
+        cerr << "FATAL: Can not open BAM file \"" << bam_file_name << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    bam_hdr_t *bamHdr = sam_hdr_read(fp_in);
+    bam1_t *aln = bam_init1();
+
+    map<string, int32_t> chrom_str2tid;
+    for (int32_t tid = 0; tid < bamHdr->n_targets; tid++) {
+        chrom_str2tid[bamHdr->target_name[tid]] = tid;
+    }
+
+    map<int32_t, vector<interval> > targets;
+    read_bed(bed_file_name, chrom_str2tid, targets);
+
+    const char *tmp_dir = getenv("TMPDIR");
+    if (tmp_dir == NULL)
+        tmp_dir = "/tmp";
+    external_counter counter;
+    if (!counter.open(tmp_dir, mem_budget)) {
+        cerr << "FATAL: Can not create spill files in \"" << tmp_dir << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    // position `pos` of contig `tid` is mapped to (tid << 32) + pos
+    map<int32_t, size_t> first_id;
+    for (auto t = targets.begin(); t != targets.end(); t++) {
+        const int64_t base = int64_t(t->first) << 32;
+        first_id[t->first] = counter.size_A();
+        for (auto i = t->second.begin(); i != t->second.end(); i++) {
+            counter.add_A(base + i->left, base + i->right);
+        }
+    }
+    vector<size_t> n_alignments(bamHdr->n_targets, 0);
+    while (sam_read1(fp_in,bamHdr,aln) > 0) {
+        const int32_t tid = aln->core.tid;
+        if (tid >= 0) {
+            const int64_t base = int64_t(tid) << 32;
+            counter.add_B(base + aln->core.pos + 1, base + aln->core.pos + aln->core.l_qseq);
+            n_alignments[tid]++;
+        }
+    }
+    bam_destroy1(aln);
+    sam_close(fp_in);
+    cout << "Spilled " << counter.size_A() << " target intervals and "
+         << counter.size_B() << " alignments" << endl;
+
+    vector<int64_t> counts;
+    size_t n_intersections;
+    const double tcount = now();
+    if (!counter.count(counts, n_intersections)) {
+        cerr << "FATAL: I/O error on the spill files in \"" << tmp_dir << "\"" << endl;
+        exit(EXIT_FAILURE);
+    }
+    const double intersection_time = now() - tcount;
+
+    ofstream out;
+    if (out_file_name != NULL) {
+        out.open(out_file_name);
+        if (out.fail()) {
+            cerr << "FATAL: Can not open output file \"" << out_file_name << "\"" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+        const int32_t tid = contig->second;
+        if (targets.count(tid)) {
+            const vector<interval> &t = targets.at(tid);
+            const size_t first = first_id.at(tid);
+            int64_t n = 0;
+            for (size_t i=0; i<t.size(); i++) {
+                n += counts[first + i];
+                if (out.is_open())
+                    out << contig->first << "\t" << t[i].left << "\t" << t[i].right << "\t" << counts[first + i] << "\n";
+            }
+            cout << "Contig \"" <<
+                contig->first << "\" has " <<
+                n_alignments[tid] << " alignments and " <<
+                t.size() << " target intervals... " <<
+                n << " intersections" << endl;
+        }
+    }
+    cout << "**" << endl
+         << "** Slabs " << counter.slabs() << endl
+         << "** Total intersections " << n_intersections << endl
+         << "** Intersection time (s) " << intersection_time << endl
+         << "** End-to-end time (s) " << now() - tstart << endl
+         << "**" << endl << endl;
+}
+
 /**
  *
  */
-void test_with_random_input(int N, int nreps)
+void test_with_random_input(long N, int nreps, engine_t engine, distribution_t dist, uint64_t seed)
 {
     double intersection_time = 0.0;
+    count_workspace ws;
 
     for (int r=0; r<nreps; r++) {
-        vector<interval> A, B;
-        vector<int> counts;
+        interval_set<int32_t> A, B;
         cout << "**" << endl
              << "** Replication " << r << " of " << nreps << endl
              << "**" << endl;
-        cout << "Generating random input..." << endl;
-        init(A, N/2);
-        init(B, N/2);
+        cout << "Generating random input (" << distribution_names[dist] << ")... " << flush;
+        const double tgen = now();
+        // each replication gets a different input
+        generate_intervals(dist, N/2, N/2, seed + r, A, B);
+        cout << "done in " << now() - tgen << " s" << endl;
         const double tstart = now();
-        count_intersections(A, B, counts);
+        count_with_engine(engine, A, B, &ws);
         const double elapsed = now() - tstart;
         intersection_time += elapsed;
     }
@@ -202,16 +1103,47 @@ void test_with_random_input(int N, int nreps)
 }
 
 
+#if INSTRUMENT
+/**
+ * Write the trace file on exit
+ */
+void stop_trace( void )
+{
+    if (!trace_stop())
+        cerr << "ERROR: Can not write the trace file" << endl;
+}
+#endif
+
 int main(int argc, char *argv[])
 {
     const char* bam_file_name = NULL;
     const char* bed_file_name = NULL;
+    const char* index_out_file_name = NULL;
+    const char* index_in_file_name = NULL;
+    const char* cache_out_file_name = NULL;
+    cache_encoding_t cache_encoding = CACHE_RAW;
     int opt;
-    int N = -1;
+    long N = -1;
     int nreps = 1;
+    int n_load_threads = 0;
+    bool streaming = false;
+    bool concurrent = false;
+    bool depth = false;
+    bool pairs = false;
+    bool mapq = false;
+    bool symmetric = false;
+    int bin_width = 0;
+    long mem_mb = 0;
+    const char* out_file_name = NULL;
+    const char* trace_file_name = NULL;
+    engine_t engine = ENGINE_SWEEP;
+    distribution_t dist = DIST_UNIFORM;
+    uint64_t seed = 1;
+    bool first_touch = false;
+    huge_pages_t pages = PAGES_DEFAULT;
 
     // parse command line arguments
-    while ((opt = getopt(argc, argv, "hm:d:N:r:")) != -1) {
+    while ((opt = getopt(argc, argv, "hm:d:w:i:k:zp:cSDW:PQTM:o:N:g:s:r:e:b:FH:t:")) != -1) {
         switch (opt) {
         case 'm': // BAM file name
             bam_file_name = optarg;
@@ -219,12 +1151,113 @@ int main(int argc, char *argv[])
         case 'd': // BED file name
             bed_file_name = optarg;
             break;
+        case 'w': // index file name (output)
+            index_out_file_name = optarg;
+            break;
+        case 'i': // index file name (input)
+            index_in_file_name = optarg;
+            break;
+        case 'k': // interval cache file name (output)
+            cache_out_file_name = optarg;
+            break;
+        case 'z': // delta encoding of the interval cache
+            cache_encoding = CACHE_DELTA;
+            break;
+        case 'p': // pipelined loading
+            n_load_threads = atoi(optarg);
+            break;
+        case 'c': // concurrent contigs
+            concurrent = true;
+            break;
+        case 'S': // streaming mode
+            streaming = true;
+            break;
+        case 'D': // depth of coverage
+            depth = true;
+            break;
+        case 'W': // bin width
+            bin_width = atoi(optarg);
+            if (bin_width <= 0) {
+                cerr << "FATAL: The bin width must be positive" << endl << endl;
+                print_help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'P': // enumerate the pairs
+            pairs = true;
+            break;
+        case 'Q': // sum of the MAPQ
+            mapq = true;
+            break;
+        case 'T': // symmetric counts
+            symmetric = true;
+            break;
+        case 'M': // memory budget of the out-of-core mode
+            mem_mb = atol(optarg);
+            if (mem_mb <= 0) {
+                cerr << "FATAL: The memory budget must be positive" << endl << endl;
+                print_help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'o': // output file name
+            out_file_name = optarg;
+            break;
         case 'N': // generate random input
-            N = atoi(optarg);
+            N = atol(optarg);
+            break;
+        case 'g': // distribution of the random input
+            if (!parse_distribution(optarg, dist)) {
+                cerr << "FATAL: Unrecognized distribution \"" << optarg << "\"" << endl << endl;
+                print_help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 's': // seed of the random input
+            seed = strtoull(optarg, NULL, 10);
             break;
 	case 'r': // number of replications
             nreps = atoi(optarg);
             break;
+        case 'e': // counting engine
+            if (!strcmp(optarg, "sweep")) {
+                engine = ENGINE_SWEEP;
+            } else if (!strcmp(optarg, "bsearch")) {
+                engine = ENGINE_BSEARCH;
+            } else if (!strcmp(optarg, "auto")) {
+                engine = ENGINE_AUTO;
+            } else {
+                cerr << "FATAL: Unrecognized engine \"" << optarg << "\"" << endl << endl;
+                print_help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'b': // width of IDs and counts
+            if (!strcmp(optarg, "32")) {
+                index_bits = 32;
+            } else if (!strcmp(optarg, "64")) {
+                index_bits = 64;
+            } else if (!strcmp(optarg, "auto")) {
+                index_bits = 0;
+            } else {
+                cerr << "FATAL: Unrecognized width \"" << optarg << "\"" << endl << endl;
+                print_help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'F': // parallel first touch
+            first_touch = true;
+            break;
+        case 'H': // huge pages
+            if (!parse_pages(optarg, pages)) {
+                cerr << "FATAL: Unrecognized pages \"" << optarg << "\"" << endl << endl;
+                print_help(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 't': // trace file name
+            trace_file_name = optarg;
+            break;
         default:
             cerr << "FATAL: Unrecognized option " << opt << endl << endl;
             print_help(argv[0]);
@@ -233,9 +1266,60 @@ int main(int argc, char *argv[])
         }
     }
 
-    if ((N < 0) && (bam_file_name == NULL || bed_file_name == NULL)) {
+    workspace_set_placement(first_touch, pages);
+#if _OPENMP
+    if (first_touch && omp_get_proc_bind() == omp_proc_bind_false) {
+        cerr << "WARNING: The threads are not bound to cores, so the pages touched by a thread" << endl
+             << "         may be scanned by another one; set OMP_PROC_BIND and OMP_PLACES" << endl;
+    }
+#endif
+
+    if (trace_file_name != NULL) {
+#if INSTRUMENT
+        if (!trace_start(trace_file_name)) {
+            cerr << "FATAL: Can not create trace file \"" << trace_file_name << "\"" << endl;
+            return EXIT_FAILURE;
+        }
+        atexit(stop_trace);
+#else
+        cerr << "FATAL: The program must be compiled with INSTRUMENT=1 to write a trace" << endl;
+        return EXIT_FAILURE;
+#endif
+    }
+
+    if (cache_out_file_name != NULL) {
+        if (bam_file_name == NULL) {
+            cerr << "FATAL: You must specify the BAM file to cache using -m" << endl << endl;
+            print_help(argv[0]);
+            return EXIT_FAILURE;
+        }
+        build_cache(bam_file_name, cache_out_file_name, cache_encoding);
+        return EXIT_SUCCESS;
+    }
+
+    if (index_out_file_name != NULL) {
+        if (bam_file_name == NULL) {
+            cerr << "FATAL: You must specify the BAM file to index using -m" << endl << endl;
+            print_help(argv[0]);
+            return EXIT_FAILURE;
+        }
+        build_index(bam_file_name, index_out_file_name);
+        return EXIT_SUCCESS;
+    }
+
+    if (bin_width > 0) {
+        if (bam_file_name == NULL) {
+            cerr << "FATAL: You must specify the BAM file using -m" << endl << endl;
+            print_help(argv[0]);
+            return EXIT_FAILURE;
+        }
+        test_bins(bam_file_name, bin_width, nreps, out_file_name);
+        return EXIT_SUCCESS;
+    }
+
+    if ((N < 0) && ((bam_file_name == NULL && index_in_file_name == NULL) || bed_file_name == NULL)) {
         cerr << "FATAL: You must either provide a number of intervals N"
-             << "       or specify BAM and BED files using -m and -d"
+             << "       or specify BAM (or index) and BED files using -m (or -i) and -d"
              << endl
              << endl;
         print_help(argv[0]);
@@ -243,9 +1327,25 @@ int main(int argc, char *argv[])
     }
 
     if (N > 0) {
-      test_with_random_input(N, nreps);
+      test_with_random_input(N, nreps, engine, dist, seed);
+    } else if (index_in_file_name != NULL) {
+      test_with_index_and_bed(index_in_file_name, bed_file_name, nreps);
+    } else if (symmetric) {
+      test_symmetric(bam_file_name, bed_file_name, nreps);
+    } else if (mapq) {
+      test_mapq(bam_file_name, bed_file_name, nreps, out_file_name);
+    } else if (pairs) {
+      test_pairs(bam_file_name, bed_file_name, nreps, out_file_name);
+    } else if (depth) {
+      test_depth(bam_file_name, bed_file_name, nreps, out_file_name);
+    } else if (mem_mb > 0) {
+      test_out_of_core(bam_file_name, bed_file_name, size_t(mem_mb) << 20, out_file_name);
+    } else if (streaming) {
+      test_streaming(bam_file_name, bed_file_name, out_file_name);
+    } else if (n_load_threads > 0) {
+      test_with_bam_and_bed_pipelined(bam_file_name, bed_file_name, nreps, engine, n_load_threads);
     } else {
-      test_with_bam_and_bed(bam_file_name, bed_file_name, nreps);
+      test_with_bam_and_bed(bam_file_name, bed_file_name, nreps, engine, concurrent);
     }
     return EXIT_SUCCESS;
 }
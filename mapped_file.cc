@@ -0,0 +1,69 @@
+/****************************************************************************
+ *
+ * mapped_file.cc - read-only memory-mapped files
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "mapped_file.hh"
+
+mapped_file::mapped_file() :
+    addr(0), len(0)
+{ }
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+bool mapped_file::open( const char *fname )
+{
+    close();
+
+    const int fd = ::open(fname, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size > 0) {
+        void *p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        addr = static_cast<const char*>(p);
+        len = st.st_size;
+    }
+    ::close(fd); // the mapping remains valid
+    return true;
+}
+
+void mapped_file::close( void )
+{
+    if (addr != 0)
+        munmap(const_cast<char*>(addr), len);
+    addr = 0;
+    len = 0;
+}
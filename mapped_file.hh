@@ -0,0 +1,57 @@
+/****************************************************************************
+ *
+ * mapped_file.hh - read-only memory-mapped files
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef MAPPED_FILE_HH
+#define MAPPED_FILE_HH
+
+#include <cstddef>
+
+/**
+ * A file mapped read-only in memory. The mapping is released when
+ * the object is destroyed.
+ */
+class mapped_file {
+public:
+    mapped_file();
+    ~mapped_file();
+
+    /**
+     * Map the file `fname` in memory; return false on error.
+     */
+    bool open( const char *fname );
+
+    /**
+     * Unmap the file (if any).
+     */
+    void close( void );
+
+    const char *data( void ) const { return addr; }
+    size_t size( void ) const { return len; }
+
+private:
+    mapped_file( const mapped_file & );
+    mapped_file& operator=( const mapped_file & );
+
+    const char *addr;
+    size_t len;
+};
+
+#endif /* MAPPED_FILE_HH */
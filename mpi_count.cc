@@ -0,0 +1,541 @@
+/****************************************************************************
+ *
+ * mpi_count.cc - distributed counting of intersections with MPI
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+/*
+ * Each contig is processed by all MPI processes: the coordinate range
+ * of the contig is partitioned across the ranks using the quantiles
+ * of a sample of the left endpoints, and each rank counts the
+ * intersections of its range with the usual (OpenMP) kernel. Rank 0
+ * reads the input, routes the intervals to the ranks, and collects
+ * the counts.
+ *
+ * An interval that crosses the boundary of a range is clipped, and
+ * sent to every rank whose range it overlaps; the part that belongs
+ * to the first of them is the "first" part, the others are
+ * "continuations". An intersection is counted on the rank whose range
+ * contains the left endpoint of the intersection, i.e., the larger
+ * left endpoint of the two intervals: any other rank where both
+ * intervals appear receives two continuations, that always overlap at
+ * the beginning of its range. Therefore, each rank subtracts the
+ * number of continuations of B from the count of each continuation
+ * of A.
+ *
+ * Run as:
+ *
+ * mpirun -np P ./intersections_mpi -N n_intervals
+ * mpirun -np P ./intersections_mpi -m BAM_file_name -d BED_file_name
+ */
+#include <iostream>
+#include <string>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cassert>
+#include <unistd.h>
+#include <mpi.h>
+#include "interval.hh"
+#include "interval_set.hh"
+#include "count_intersections.hh"
+#include "bed_reader.hh"
+#include "generate.hh"
+#include "utils.hh"
+
+#include <htslib/sam.h>
+
+using namespace std;
+
+/* Number of left endpoints sampled for each rank to choose the
+   boundaries of the ranges */
+int samples_per_rank = 256;
+
+/* The intervals of a contig routed to one rank: first the first parts
+   of A, then the continuations of A, then the first parts of B, then
+   the continuations of B. `ids` holds the index of each part of A in
+   the whole contig. */
+struct route {
+    vector<int32_t> A_left, A_right, B_left, B_right;
+    vector<size_t> ids;
+    size_t A_first;
+    size_t B_first;
+
+    route() : A_first(0), B_first(0) { }
+};
+
+/* Header of the intervals sent to each rank */
+enum {
+    HDR_A,          // parts of A
+    HDR_A_FIRST,    // first parts of A
+    HDR_B,          // parts of B
+    HDR_B_FIRST,    // first parts of B
+    HDR_SIZE
+};
+
+void print_help(const char *exe_name)
+{
+    cerr << "Usage: mpirun -np P " << exe_name << " [-N n_intervals [-g distribution]] [-m BAM_file_name -d BED_file_name] [-r nreps] [-s samples]" << endl << endl
+         << "where:" << endl << endl
+         << "-m BAM_file_name" << endl
+         << "-d BED_file_name" << endl
+         << "-N n_intervals\tgenerate n_intervals random intervals (half A, half B)" << endl
+         << "-g distribution\tdistribution of the random intervals: uniform (default), exome," << endl
+         << "\t\theavy or nested (see generate.hh)" << endl
+         << "-r nreps\tperforms nreps replications" << endl
+         << "-s samples\tnumber of left endpoints sampled for each rank (default " << samples_per_rank << ")" << endl
+         << "-h\t\tThis help message" << endl << endl;
+}
+
+/**
+ * Return the boundaries of the ranges assigned to `n_ranks` ranks:
+ * rank r gets the coordinates in [start[r], start[r+1]), where
+ * start[0] = INT32_MIN and start[n_ranks] = INT32_MAX. The boundaries
+ * are the quantiles of a sample of the left endpoints of A and B.
+ */
+vector<int64_t> partition( const interval_set<int32_t> &A, const interval_set<int32_t> &B, int n_ranks )
+{
+    const size_t n = A.size() + B.size();
+    const size_t n_samples = min(n, size_t(samples_per_rank) * n_ranks);
+    vector<int32_t> sample(n_samples);
+    for (size_t k=0; k<n_samples; k++) {
+        const size_t i = k * n / n_samples; // evenly spaced
+        sample[k] = (i < A.size() ? A.left(i) : B.left(i - A.size()));
+    }
+    sort(sample.begin(), sample.end());
+    vector<int64_t> start(n_ranks + 1);
+    start[0] = INT32_MIN;
+    for (int r=1; r<n_ranks; r++) {
+        start[r] = (n_samples > 0 ? sample[r * n_samples / n_ranks] : INT32_MAX);
+    }
+    start[n_ranks] = INT32_MAX;
+    return start;
+}
+
+/**
+ * Append the parts of the intervals of `S` to the routes of the
+ * ranks whose range they overlap: only the first parts if `first` is
+ * true, only the continuations otherwise. If `is_A` is true, `S` is
+ * A, and the index of each part is appended to `ids` as well.
+ */
+void route_intervals( const interval_set<int32_t> &S,
+                      const vector<int64_t> &start,
+                      vector<route> &routes,
+                      bool first,
+                      bool is_A )
+{
+    for (size_t i=0; i<S.size(); i++) {
+        const int32_t l = S.left(i), r = S.right(i);
+        const int r_first = upper_bound(start.begin(), start.end(), int64_t(l)) - start.begin() - 1;
+        const int r_last = (first ? r_first : upper_bound(start.begin(), start.end(), int64_t(r)) - start.begin() - 1);
+        for (int k=(first ? r_first : r_first + 1); k<=r_last; k++) {
+            if (start[k] == start[k+1])
+                continue; // empty range (repeated quantile)
+            route &rt = routes[k];
+            const int32_t pl = max(int64_t(l), start[k]);
+            const int32_t pr = min(int64_t(r), start[k+1] - 1);
+            if (is_A) {
+                rt.A_left.push_back(pl);
+                rt.A_right.push_back(k+1 == int(routes.size()) ? r : pr);
+                rt.ids.push_back(i);
+            } else {
+                rt.B_left.push_back(pl);
+                rt.B_right.push_back(k+1 == int(routes.size()) ? r : pr);
+            }
+        }
+    }
+}
+
+/* Count the intersections of the local intervals, and store the count
+   of each part of A in `counts` */
+template<typename Count>
+size_t count_local( const interval_set<int32_t> &A, const interval_set<int32_t> &B, vector<int64_t> &counts )
+{
+    vector<Count> c;
+    const size_t n_intersections = count_intersections(A, B, c);
+    counts.assign(c.begin(), c.end());
+    return n_intersections;
+}
+
+/* Scatter the vectors v[0], ... v[n_ranks-1] of rank 0; on exit,
+   `out` holds the vector sent to the calling rank */
+template<typename T>
+void scatter( const vector< vector<T> > &v, vector<T> &out, size_t n, MPI_Datatype type )
+{
+    int my_rank, n_ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+    vector<int> sendcounts, displs;
+    vector<T> sendbuf;
+    if (my_rank == 0) {
+        sendcounts.resize(n_ranks);
+        displs.resize(n_ranks);
+        size_t total = 0;
+        for (int r=0; r<n_ranks; r++) {
+            total += v[r].size();
+        }
+        assert(total <= size_t(INT_MAX));
+        sendbuf.reserve(total);
+        for (int r=0; r<n_ranks; r++) {
+            sendcounts[r] = v[r].size();
+            displs[r] = sendbuf.size();
+            sendbuf.insert(sendbuf.end(), v[r].begin(), v[r].end());
+        }
+    }
+    out.resize(n);
+    MPI_Scatterv(sendbuf.data(), sendcounts.data(), displs.data(), type,
+                 out.data(), n, type, 0, MPI_COMM_WORLD);
+}
+
+/**
+ * Count how many intervals of `B` overlap each interval of `A`; all
+ * ranks must call this function, but A and B are only used by rank
+ * 0, where `counts` is filled with the results. Return the number of
+ * intersections (on rank 0), and add to `kernel_time` the time spent
+ * by the slowest rank in the kernel.
+ */
+size_t count_distributed( const interval_set<int32_t> &A,
+                          const interval_set<int32_t> &B,
+                          vector<int64_t> &counts,
+                          double &kernel_time )
+{
+    int my_rank, n_ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+
+    vector<route> routes;
+    vector<long long> hdr(HDR_SIZE * n_ranks);
+    if (my_rank == 0) {
+        const vector<int64_t> start = partition(A, B, n_ranks);
+        routes.resize(n_ranks);
+        route_intervals(A, start, routes, true, true);
+        route_intervals(B, start, routes, true, false);
+        for (int r=0; r<n_ranks; r++) {
+            routes[r].A_first = routes[r].A_left.size();
+            routes[r].B_first = routes[r].B_left.size();
+        }
+        route_intervals(A, start, routes, false, true);
+        route_intervals(B, start, routes, false, false);
+        for (int r=0; r<n_ranks; r++) {
+            hdr[HDR_SIZE*r + HDR_A] = routes[r].A_left.size();
+            hdr[HDR_SIZE*r + HDR_A_FIRST] = routes[r].A_first;
+            hdr[HDR_SIZE*r + HDR_B] = routes[r].B_left.size();
+            hdr[HDR_SIZE*r + HDR_B_FIRST] = routes[r].B_first;
+        }
+    }
+    long long my_hdr[HDR_SIZE];
+    MPI_Scatter(hdr.data(), HDR_SIZE, MPI_LONG_LONG, my_hdr, HDR_SIZE, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+    /* Each coordinate array is scattered on its own */
+    vector< vector<int32_t> > parts(n_ranks);
+    interval_set<int32_t> my_A, my_B;
+    vector<int32_t> lefts, rights;
+    for (int r=0; r<n_ranks && my_rank==0; r++) parts[r].swap(routes[r].A_left);
+    scatter(parts, lefts, my_hdr[HDR_A], MPI_INT32_T);
+    for (int r=0; r<n_ranks && my_rank==0; r++) parts[r].swap(routes[r].A_right);
+    scatter(parts, rights, my_hdr[HDR_A], MPI_INT32_T);
+    my_A.reserve(lefts.size());
+    for (size_t i=0; i<lefts.size(); i++) {
+        my_A.push_back(lefts[i], rights[i]);
+    }
+    for (int r=0; r<n_ranks && my_rank==0; r++) parts[r].swap(routes[r].B_left);
+    scatter(parts, lefts, my_hdr[HDR_B], MPI_INT32_T);
+    for (int r=0; r<n_ranks && my_rank==0; r++) parts[r].swap(routes[r].B_right);
+    scatter(parts, rights, my_hdr[HDR_B], MPI_INT32_T);
+    my_B.reserve(lefts.size());
+    for (size_t i=0; i<lefts.size(); i++) {
+        my_B.push_back(lefts[i], rights[i]);
+    }
+
+    const double tstart = now();
+    vector<int64_t> my_counts;
+    if (needs_64bit_counts(my_A.size(), my_B.size())) {
+        count_local<int64_t>(my_A, my_B, my_counts);
+    } else {
+        count_local<int>(my_A, my_B, my_counts);
+    }
+    const long long B_cont = my_hdr[HDR_B] - my_hdr[HDR_B_FIRST];
+    for (size_t i=my_hdr[HDR_A_FIRST]; i<my_counts.size(); i++) {
+        my_counts[i] -= B_cont;
+    }
+    const double my_time = now() - tstart;
+    double max_time;
+    MPI_Reduce(&my_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    /* The counts of the parts of A are sent back to rank 0, which owns
+       A, in the same order they have been received */
+    vector<int> recvcounts, displs;
+    vector<int64_t> all_counts;
+    if (my_rank == 0) {
+        recvcounts.resize(n_ranks);
+        displs.resize(n_ranks);
+        size_t total = 0;
+        for (int r=0; r<n_ranks; r++) {
+            recvcounts[r] = hdr[HDR_SIZE*r + HDR_A];
+            displs[r] = total;
+            total += recvcounts[r];
+        }
+        assert(total <= size_t(INT_MAX));
+        all_counts.resize(total);
+    }
+    MPI_Gatherv(my_counts.data(), my_counts.size(), MPI_INT64_T,
+                all_counts.data(), recvcounts.data(), displs.data(), MPI_INT64_T,
+                0, MPI_COMM_WORLD);
+
+    size_t n_intersections = 0;
+    if (my_rank == 0) {
+        kernel_time += max_time;
+        counts.assign(A.size(), 0);
+        for (int r=0; r<n_ranks; r++) {
+            const vector<size_t> &ids = routes[r].ids;
+            for (size_t i=0; i<ids.size(); i++) {
+                counts[ids[i]] += all_counts[displs[r] + i];
+                n_intersections += all_counts[displs[r] + i];
+            }
+        }
+    }
+    return n_intersections;
+}
+
+/**
+ * Read the alignments from the BAM file `bam_file_name`; on exit,
+ * `chrom_str2tid` maps the name of each contig to its ID, and
+ * `alignments` maps the ID of each contig to its alignments.
+ */
+void read_bam( const char *bam_file_name,
+               map<string, int32_t> &chrom_str2tid,
+               map<int32_t, interval_set<int32_t> > &alignments )
+{
+    samFile *fp_in = hts_open(bam_file_name,"r");
+    if (fp_in == NULL) {
+        cerr << "FATAL: Can not open BAM file \"" << bam_file_name << "\"" << endl;
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    bam_hdr_t *bamHdr = sam_hdr_read(fp_in);
+    bam1_t *aln = bam_init1();
+
+    chrom_str2tid.clear();
+    for (int32_t tid = 0; tid < bamHdr->n_targets; tid++) {
+        chrom_str2tid[bamHdr->target_name[tid]] = tid;
+    }
+
+    alignments.clear();
+    while (sam_read1(fp_in,bamHdr,aln) > 0) {
+        if (aln->core.tid >= 0) {
+            alignments[aln->core.tid].push_back(aln->core.pos + 1, aln->core.pos + aln->core.l_qseq);
+        }
+    }
+    bam_destroy1(aln);
+    sam_close(fp_in);
+}
+
+/**
+ * Count the intersections between the target intervals in the BED
+ * file `bed_file_name` and the alignments in the BAM file
+ * `bam_file_name`; only rank 0 reads the files.
+ */
+void test_with_bam_and_bed( const char *bam_file_name, const char *bed_file_name, int nreps )
+{
+    int my_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    const double tstart = now();
+    map<string, int32_t> chrom_str2tid;
+    map<int32_t, interval_set<int32_t> > alignments;
+    map<int32_t, vector<interval> > targets;
+    /* The contigs that have both alignments and targets */
+    vector<int32_t> contigs;
+    vector<string> names;
+    if (my_rank == 0) {
+        read_bam(bam_file_name, chrom_str2tid, alignments);
+        names.resize(chrom_str2tid.size());
+        for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+            names[contig->second] = contig->first;
+        }
+        string error;
+        if (!read_bed_file(bed_file_name, contig_table(names), targets, error)) {
+            cerr << "FATAL: Can not read BED file \"" << bed_file_name << "\": " << error << endl;
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        for (auto contig = chrom_str2tid.begin(); contig != chrom_str2tid.end(); contig++) {
+            if (alignments.count(contig->second) && targets.count(contig->second))
+                contigs.push_back(contig->second);
+        }
+    }
+    int n_contigs = contigs.size();
+    MPI_Bcast(&n_contigs, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    double intersection_time = 0, kernel_time = 0;
+    const interval_set<int32_t> empty;
+    vector<int64_t> counts;
+    for (int r = 0; r<nreps; r++) {
+        if (my_rank == 0) {
+            cout << "**" << endl
+                 << "** Replication " << r+1 << " of " << nreps << endl
+                 << "**" << endl;
+        }
+        for (int c=0; c<n_contigs; c++) {
+            interval_set<int32_t> windows;
+            const interval_set<int32_t> *aln = &empty;
+            if (my_rank == 0) {
+                const int32_t tid = contigs[c];
+                windows = interval_set<int32_t>(targets.at(tid));
+                aln = &alignments.at(tid);
+                cout << "Contig \"" <<
+                    names[tid] << "\" has " <<
+                    aln->size() << " alignments and " <<
+                    windows.size() << " target intervals... " << flush;
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+            const double tcontig = now();
+            const size_t n_intersections = count_distributed(windows, *aln, counts, kernel_time);
+            intersection_time += now() - tcontig;
+            if (my_rank == 0) {
+                cout << n_intersections << " intersections" << endl;
+            }
+        }
+    }
+    if (my_rank == 0) {
+        cout << "**" << endl
+             << "** Average intersection time (s) " << intersection_time/nreps << endl
+             << "** Average kernel time (s) " << kernel_time/nreps << endl
+             << "** End-to-end time (s) " << now() - tstart << endl
+             << "**" << endl << endl;
+    }
+}
+
+/**
+ * Count the intersections between two sets of N/2 random intervals
+ * generated by rank 0
+ */
+void test_with_random_input( long N, int nreps, distribution_t dist )
+{
+    int my_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+    double intersection_time = 0, kernel_time = 0;
+    interval_set<int32_t> A, B;
+    vector<int64_t> counts;
+    for (int r=0; r<nreps; r++) {
+        if (my_rank == 0) {
+            // same inputs as "intersections -N N -g dist"
+            generate_intervals(dist, N/2, N/2, 1 + r, A, B);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+        const double tstart = now();
+        const size_t n_intersections = count_distributed(A, B, counts, kernel_time);
+        intersection_time += now() - tstart;
+        if (my_rank == 0) {
+            cout << "Replication " << r+1 << " of " << nreps << ": " << n_intersections << " intersections" << endl;
+        }
+    }
+    if (my_rank == 0) {
+        cout << "Intersection time " << intersection_time/nreps << endl
+             << "Kernel time " << kernel_time/nreps << endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char* bam_file_name = NULL;
+    const char* bed_file_name = NULL;
+    int opt;
+    long N = -1;
+    int nreps = 1;
+    distribution_t dist = DIST_UNIFORM;
+    int my_rank, n_ranks;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+
+    // parse command line arguments
+    while ((opt = getopt(argc, argv, "hm:d:N:g:r:s:")) != -1) {
+        switch (opt) {
+        case 'm': // BAM file name
+            bam_file_name = optarg;
+            break;
+        case 'd': // BED file name
+            bed_file_name = optarg;
+            break;
+        case 'N': // generate random input
+            N = atol(optarg);
+            break;
+        case 'g': // distribution of the random input
+            if (!parse_distribution(optarg, dist)) {
+                if (my_rank == 0) {
+                    cerr << "FATAL: Unrecognized distribution \"" << optarg << "\"" << endl << endl;
+                    print_help(argv[0]);
+                }
+                MPI_Finalize();
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'r': // number of replications
+            nreps = atoi(optarg);
+            break;
+        case 's': // samples per rank
+            samples_per_rank = atoi(optarg);
+            if (samples_per_rank <= 0) {
+                if (my_rank == 0) {
+                    cerr << "FATAL: The number of samples must be positive" << endl << endl;
+                    print_help(argv[0]);
+                }
+                MPI_Finalize();
+                return EXIT_FAILURE;
+            }
+            break;
+        default:
+            if (my_rank == 0) {
+                cerr << "FATAL: Unrecognized option " << opt << endl << endl;
+                print_help(argv[0]);
+            }
+            MPI_Finalize();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ((N < 0) && (bam_file_name == NULL || bed_file_name == NULL)) {
+        if (my_rank == 0) {
+            cerr << "FATAL: You must either provide a number of intervals N"
+                 << "       or specify BAM and BED files using -m and -d"
+                 << endl
+                 << endl;
+            print_help(argv[0]);
+        }
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    /* Only rank 0 writes to the standard output; this also silences
+       the banners printed by the kernel on the other ranks */
+    if (my_rank == 0) {
+        cout << "MPI processes: " << n_ranks << endl;
+    } else {
+        cout.rdbuf(NULL);
+    }
+    if (N > 0) {
+        test_with_random_input(N, nreps, dist);
+    } else {
+        test_with_bam_and_bed(bam_file_name, bed_file_name, nreps);
+    }
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+}
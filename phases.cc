@@ -0,0 +1,75 @@
+/****************************************************************************
+ *
+ * phases.cc - wall-clock time of the phases of the kernels
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#if _OPENMP
+#include <omp.h>
+#endif
+#include "utils.hh"
+#include "phases.hh"
+#include "trace.hh"
+
+const char *phase_names[N_PHASES] = { "build", "sort", "scan", "update", "gather" };
+
+static phase_timer *active = NULL;
+
+void phase_timer_set( phase_timer *t )
+{
+    active = t;
+}
+
+/* Only the outermost kernel records its phases */
+static bool recording( void )
+{
+#if _OPENMP
+    return (active != NULL && omp_get_level() == 0);
+#else
+    return (active != NULL);
+#endif
+}
+
+void phase_start( void )
+{
+    TRACE_MARK();
+    if (recording())
+        active->last = now();
+}
+
+void phase_end( phase_id p )
+{
+#if INSTRUMENT
+    phase_end_at(p, now());
+#else
+    if (recording())
+        phase_end_at(p, now());
+#endif
+}
+
+/* The phases are traced by all threads, including those running
+   nested kernels */
+void phase_end_at( phase_id p, double t )
+{
+    TRACE_MARK_EVENT(phase_names[p], "phase", t);
+    if (recording()) {
+        active->elapsed[p] += t - active->last;
+        active->last = t;
+    }
+}
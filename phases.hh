@@ -0,0 +1,91 @@
+/****************************************************************************
+ *
+ * phases.hh - wall-clock time of the phases of the kernels
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef PHASES_HH
+#define PHASES_HH
+
+/**
+ * Phases of the counting kernels:
+ *
+ * - build: copy the coordinates and build the array of endpoints;
+ * - sort: sort the endpoints (for the bsearch engine, this is the
+ *   construction of the sorted arrays of endpoints of B);
+ * - scan: count the endpoints of B;
+ * - update: update the counts of the intervals of A;
+ * - gather: copy the counts back to the host and compute the total.
+ */
+enum phase_id {
+    PHASE_BUILD,
+    PHASE_SORT,
+    PHASE_SCAN,
+    PHASE_UPDATE,
+    PHASE_GATHER,
+    N_PHASES
+};
+
+extern const char *phase_names[N_PHASES];
+
+/**
+ * Wall-clock time spent in each phase, accumulated over all calls
+ * to the kernels while the timer is active (see phase_timer_set()).
+ */
+struct phase_timer {
+    double elapsed[N_PHASES];
+    double last;
+
+    phase_timer() { reset(); }
+
+    void reset( void )
+    {
+        for (int p=0; p<N_PHASES; p++)
+            elapsed[p] = 0.0;
+        last = 0.0;
+    }
+};
+
+/**
+ * The kernels record the time of their phases in `t`, until
+ * phase_timer_set(NULL) is called. Calls from inside a parallel
+ * region are not recorded.
+ */
+void phase_timer_set( phase_timer *t );
+
+/**
+ * Start timing the first phase of a kernel
+ */
+void phase_start( void );
+
+/**
+ * Add the time elapsed since the previous call to phase_start() or
+ * phase_end() to phase `p`. Without an active timer, this costs a
+ * single test.
+ */
+void phase_end( phase_id p );
+
+/**
+ * Same as phase_end(), where phase `p` ended at time `t` (as returned
+ * by now()); this is used for phases that end inside a parallel
+ * region, where the time is taken by the master thread.
+ */
+void phase_end_at( phase_id p, double t );
+
+#endif /* PHASES_HH */
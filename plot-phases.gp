@@ -0,0 +1,36 @@
+## plot the median time of each phase of the counting kernels, as
+## measured by the bench_* programs ("make bench")
+##
+## Run with:
+##
+## ./bench_stl -n 1000000,10000000 -t 4 -o test_results/phases.csv
+## gnuplot -e "datafile='test_results/phases.csv'" plot-phases.gp
+##
+## Each row of the CSV file (one configuration) becomes a stacked bar.
+## The plot goes to phases.eps
+##
+## Last updated 2026-10-17 Moreno Marzolla
+
+if (!exists("datafile")) datafile = "test_results/phases.csv"
+
+set term postscript eps color linewidth 1.2
+set size .7
+set output "phases.eps"
+set datafile separator ","
+set style data histograms
+set style histogram rowstacked
+set style fill solid 0.8 border -1
+set boxwidth 0.7
+set key top left
+set xtics rotate by -45 font ",10"
+set xlabel "Configuration (n/m/density/threads)"
+set ylabel "Median wall-clock time (s)"
+set title "Time of the phases"
+
+label(n, m, d, t) = sprintf("%.0f/%.0f/%g/%.0f", n, m, d, t)
+
+plot datafile using (column("build_median")):xtic(label(column("n"), column("m"), column("density"), column("threads"))) title "build", \
+     "" using (column("sort_median")) title "sort", \
+     "" using (column("scan_median")) title "scan", \
+     "" using (column("update_median")) title "update", \
+     "" using (column("gather_median")) title "gather"
@@ -0,0 +1,117 @@
+/****************************************************************************
+ *
+ * radix_sort.cc - parallel LSD radix sort
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <omp.h>
+#include "radix_sort.hh"
+
+// Number of bits of each digit
+static const int RADIX_BITS = 8;
+static const size_t RADIX = (size_t(1) << RADIX_BITS);
+
+template<typename T>
+static void radix_sort_impl( T *keys, T *tmp, size_t n, int lo_bit )
+{
+    const int key_bits = 8*sizeof(T);
+
+    if (n < 2)
+        return;
+
+    /* A digit needs to be sorted only if it is not the same in all
+       keys, i.e., only if some bit in that digit differs between the
+       bitwise AND and the bitwise OR of all keys. */
+    T all_or = 0, all_and = ~T(0);
+#pragma omp parallel for reduction(|:all_or) reduction(&:all_and)
+    for (size_t i=0; i<n; i++) {
+        all_or |= keys[i];
+        all_and &= keys[i];
+    }
+    const T varying = all_or ^ all_and;
+
+    const int max_threads = omp_get_max_threads();
+    /* hist[t*RADIX + d] is initially the number of keys with digit d
+       in the block of thread t; it is then replaced by the position
+       where thread t must store the first such key. */
+    std::vector<size_t> hist(max_threads * RADIX);
+
+    T *src = keys, *dst = tmp;
+    for (int shift = lo_bit; shift < key_bits; shift += RADIX_BITS) {
+        const T digit_mask = T(RADIX - 1) << shift;
+        if ((varying & digit_mask) == 0)
+            continue;
+
+#pragma omp parallel
+        {
+            const int n_threads = omp_get_num_threads();
+            const int my_id = omp_get_thread_num();
+            const size_t my_start = n * my_id / n_threads;
+            const size_t my_end = n * (my_id + 1) / n_threads;
+            size_t *my_hist = &hist[my_id * RADIX];
+
+            std::fill(my_hist, my_hist + RADIX, 0);
+            for (size_t i=my_start; i<my_end; i++) {
+                my_hist[(src[i] >> shift) & (RADIX - 1)]++;
+            }
+#pragma omp barrier
+#pragma omp single
+            {
+                size_t ofs = 0;
+                for (size_t d=0; d<RADIX; d++) {
+                    for (int t=0; t<n_threads; t++) {
+                        const size_t cnt = hist[t*RADIX + d];
+                        hist[t*RADIX + d] = ofs;
+                        ofs += cnt;
+                    }
+                }
+            } // implicit barrier here
+            for (size_t i=my_start; i<my_end; i++) {
+                const T k = src[i];
+                dst[my_hist[(k >> shift) & (RADIX - 1)]++] = k;
+            }
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != keys) {
+#pragma omp parallel for
+        for (size_t i=0; i<n; i++) {
+            keys[i] = src[i];
+        }
+    }
+}
+
+void radix_sort( uint64_t *keys, uint64_t *tmp, size_t n, int lo_bit )
+{
+    radix_sort_impl(keys, tmp, n, lo_bit);
+}
+
+void radix_sort( uint32_t *keys, uint32_t *tmp, size_t n, int lo_bit )
+{
+    radix_sort_impl(keys, tmp, n, lo_bit);
+}
+
+#ifdef __SIZEOF_INT128__
+__extension__ void radix_sort( unsigned __int128 *keys, unsigned __int128 *tmp, size_t n, int lo_bit )
+{
+    radix_sort_impl(keys, tmp, n, lo_bit);
+}
+#endif
@@ -0,0 +1,43 @@
+/****************************************************************************
+ *
+ * radix_sort.hh - parallel LSD radix sort
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef RADIX_SORT_HH
+#define RADIX_SORT_HH
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Sort the `n` unsigned integers in `keys` in nondecreasing order
+ * using a parallel (OpenMP) least-significant-digit radix sort. Only
+ * bits `lo_bit` and above take part in the comparison; the sort is
+ * stable, so keys that differ only in the lower bits keep their
+ * relative order. `tmp` must point to a scratch area of (at least)
+ * `n` elements; its content is destroyed. Passes whose digit has the
+ * same value in all keys are skipped.
+ */
+void radix_sort( uint64_t *keys, uint64_t *tmp, size_t n, int lo_bit = 0 );
+void radix_sort( uint32_t *keys, uint32_t *tmp, size_t n, int lo_bit = 0 );
+#ifdef __SIZEOF_INT128__
+__extension__ void radix_sort( unsigned __int128 *keys, unsigned __int128 *tmp, size_t n, int lo_bit = 0 );
+#endif
+
+#endif /* RADIX_SORT_HH */
@@ -20,8 +20,6 @@
  *
  ****************************************************************************/
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <map>
 #include <vector>
@@ -29,14 +27,12 @@ extern "C" {
 #include <htslib/sam.h>
 }
 #include "interval.hh"
+#include "interval_set.hh"
+#include "bed_reader.hh"
+#include "depth.hh"
 
 using namespace std;
 
-void intersection(const vector<interval> &a, const vector<interval> &b)
-{
-    // count how many intervals in a overlap each interval in b
-}
-
 int main(int argc, char *argv[])
 {
     if (argc != 3) {
@@ -56,36 +52,24 @@ int main(int argc, char *argv[])
     }
 
     // get alignment intervals from bam
-    map<int32_t, vector<interval> > alignments;
+    map<int32_t, interval_set<int32_t> > alignments;
     while (sam_read1(fp_in,bamHdr,aln) > 0) {
-        interval i;
-        i.id = 0;
-        i.left = aln->core.pos + 1;
-        i.right = aln->core.pos + aln->core.l_qseq;
-        i.payload = 0;
-        alignments[aln->core.tid].push_back(i);
+        alignments[aln->core.tid].push_back(aln->core.pos + 1, aln->core.pos + aln->core.l_qseq);
     }
     bam_destroy1(aln);
     sam_close(fp_in);
     //cout << "Loaded " << alignments.size() << " alignments" << endl;
 
     // get target intervals from bed
+    vector<string> names;
+    for (int32_t tid = 0; tid < bamHdr->n_targets; tid++) {
+        names.push_back(bamHdr->target_name[tid]);
+    }
     map<int32_t, vector<interval> > targets;
-    ifstream bed;
-    bed.open(argv[2]);
-    string chrom_str;
-    int32_t start, end;
-    string line;
-    while (getline(bed, line)) {
-        istringstream ss(line);
-        ss >> chrom_str >> start >> end;
-        int32_t tid = chrom_str2tid.at(chrom_str2tid.count(chrom_str) ? chrom_str : chrom_str.substr(3));
-        interval i;
-        i.id = 0;
-        i.left = start;
-        i.right = end;
-        i.payload = 0;
-        targets[tid].push_back(i);
+    string error;
+    if (!read_bed_file(argv[2], contig_table(names), targets, error)) {
+        cerr << "FATAL: Can not read BED file \"" << argv[2] << "\": " << error << endl;
+        return EXIT_FAILURE;
     }
     //cout << "Loaded " << targets.size() << " target intervals" << endl;
 
@@ -95,18 +79,11 @@ int main(int argc, char *argv[])
         if (alignments.count(tid) && targets.count(tid)) {
             cout << "Contig \"" << contig->first << "\" has " << alignments.at(tid).size() << " alignments and " << targets.at(tid).size() << " target intervals" << endl;
 
-            // split target intervals into 1-base windows
-            vector<interval> windows;
-            for (auto t = targets.at(tid).begin(); t != targets.at(tid).end(); t++)
-                for (int32_t pos = t->left; pos < t->right; pos++) {
-                    interval i;
-                    i.id = 0;
-                    i.left = pos;
-                    i.right = pos + 1;
-                    i.payload = 0;
-                    windows.push_back(i);
-                }
-            intersection(alignments.at(tid), windows);
+            // count how many alignments overlap each base of the targets
+            vector<size_t> offsets;
+            vector<int> depth;
+            const size_t total = depth_of_coverage(interval_set<int32_t>(targets.at(tid)), alignments.at(tid), offsets, depth);
+            cout << depth.size() << " bases, total depth " << total << endl;
         }
     }
 
@@ -0,0 +1,51 @@
+/****************************************************************************
+ *
+ * scheduler.cc - run per-contig jobs concurrently
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <omp.h>
+#include "scheduler.hh"
+
+void run_jobs( std::vector<job> &jobs, size_t small_job_size )
+{
+    std::vector<size_t> order(jobs.size());
+    for (size_t i=0; i<jobs.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) {
+            return jobs[a].size > jobs[b].size;
+        });
+
+    size_t first_small = 0;
+    while (first_small < order.size() && jobs[order[first_small]].size >= small_job_size) {
+        jobs[order[first_small]].run();
+        first_small++;
+    }
+
+    if (first_small < order.size()) {
+#pragma omp parallel
+#pragma omp single
+        for (size_t i=first_small; i<order.size(); i++) {
+            job *j = &jobs[order[i]];
+#pragma omp task firstprivate(j)
+            j->run();
+        }
+    }
+}
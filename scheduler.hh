@@ -0,0 +1,58 @@
+/****************************************************************************
+ *
+ * scheduler.hh - run per-contig jobs concurrently
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef SCHEDULER_HH
+#define SCHEDULER_HH
+
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+/**
+ * A unit of work, usually the intersections of a single contig.
+ * `size` is an estimate of the cost of the job (e.g., the total
+ * number of endpoints); `run` does the work, and is called from
+ * inside an OpenMP parallel region when the job is executed
+ * concurrently with other jobs.
+ */
+struct job {
+    size_t size;
+    std::function<void(void)> run;
+};
+
+/**
+ * Jobs whose size is below this threshold are run concurrently as
+ * serial tasks; larger jobs are run one at a time, using all threads.
+ */
+const size_t SMALL_JOB_SIZE = 1 << 18;
+
+/**
+ * Run all jobs in `jobs` in order of decreasing size. Large jobs are
+ * executed one at a time by the calling thread, so that they can use
+ * the parallel counting kernels; small jobs are then executed as
+ * independent OpenMP tasks, so that idle threads pick up (or steal)
+ * the remaining jobs. The small jobs are started largest-first, to
+ * reduce the imbalance at the end.
+ */
+void run_jobs( std::vector<job> &jobs, size_t small_job_size = SMALL_JOB_SIZE );
+
+#endif
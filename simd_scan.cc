@@ -0,0 +1,283 @@
+/****************************************************************************
+ *
+ * simd_scan.cc - vectorized scan of the sorted endpoints
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+/* The AVX2 and AVX-512 kernels are compiled with target attributes,
+   so that the rest of the program does not require these
+   instruction sets; the kernel to use is chosen at run time. */
+
+#include <cstring>
+#include "endpoint.hh"
+#include "simd_scan.hh"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define HAVE_X86_SIMD 0
+#endif
+
+const char *isa_names[N_ISAS] = { "scalar", "avx2", "avx512" };
+
+typedef endpoint ep;
+static_assert(ep::ID_BITS == 30 && ep::HALF_BITS == 32, "unexpected layout of the endpoints");
+
+/* Update the count of the interval of A that key `k` belongs to,
+   where `cnt` is the counter of the endpoints of B up to k; return
+   the contribution to the number of intersections */
+static inline uint64_t update_A( uint64_t k, uint64_t cnt, int *counts )
+{
+    const size_t id = ep::id(k);
+    if (ep::extreme(k) == ep::LEFT) {
+        const int nr = ep::nright(cnt);
+#pragma omp atomic
+        counts[id] -= nr;
+        return -uint64_t(nr);
+    } else {
+        const int nl = ep::nleft(cnt);
+#pragma omp atomic
+        counts[id] += nl;
+        return uint64_t(nl);
+    }
+}
+
+static uint64_t count_B_scalar( const uint64_t *keys, size_t n )
+{
+    uint64_t cnt = 0;
+    for (size_t i=0; i<n; i++) {
+        cnt += ep::count_B(keys[i]);
+    }
+    return cnt;
+}
+
+static uint64_t update_counts_scalar( const uint64_t *keys, size_t n, uint64_t cnt, int *counts )
+{
+    uint64_t n_intersections = 0;
+    for (size_t i=0; i<n; i++) {
+        const uint64_t k = keys[i];
+        cnt += ep::count_B(k);
+        if (ep::type(k) == ep::SET_A)
+            n_intersections += update_A(k, cnt, counts);
+    }
+    return n_intersections;
+}
+
+#if HAVE_X86_SIMD
+
+/* GCC 12 reports the undefined vectors used internally by the AVX-512
+   intrinsics as uninitialized */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+/* The bits e (extreme) and t (type) of the keys are bits 31 and 30
+   (see endpoint.hh). The contribution of a key to the counter is
+   t << (32*e): 1 for a left endpoint of B, 1 << 32 for a right
+   endpoint of B, and 0 for the endpoints of A. */
+
+__attribute__((target("avx2")))
+static inline __m256i count_B_avx2( __m256i k )
+{
+    const __m256i f = _mm256_srli_epi64(k, ep::ID_BITS);
+    const __m256i t = _mm256_and_si256(f, _mm256_set1_epi64x(1));
+    const __m256i shift = _mm256_slli_epi64(_mm256_and_si256(_mm256_srli_epi64(f, 1), _mm256_set1_epi64x(1)), 5);
+    return _mm256_sllv_epi64(t, shift);
+}
+
+__attribute__((target("avx2")))
+static uint64_t count_B_avx2( const uint64_t *keys, size_t n )
+{
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i+4 <= n; i += 4) {
+        const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        acc = _mm256_add_epi64(acc, count_B_avx2(k));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + count_B_scalar(keys + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t update_counts_avx2( const uint64_t *keys, size_t n, uint64_t cnt, int *counts )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i type_bit = _mm256_set1_epi64x(uint64_t(1) << ep::ID_BITS);
+    __m256i carry = _mm256_set1_epi64x(cnt);
+    uint64_t n_intersections = 0;
+    size_t i = 0;
+    for (; i+4 <= n; i += 4) {
+        const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        // inclusive prefix sum of the 4 lanes: shift by 1, then by 2 lanes
+        __m256i c = count_B_avx2(k);
+        c = _mm256_add_epi64(c, _mm256_blend_epi32(_mm256_permute4x64_epi64(c, _MM_SHUFFLE(2,1,0,0)), zero, 0x03));
+        c = _mm256_add_epi64(c, _mm256_blend_epi32(_mm256_permute4x64_epi64(c, _MM_SHUFFLE(1,0,0,0)), zero, 0x0F));
+        c = _mm256_add_epi64(c, carry);
+        carry = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(3,3,3,3));
+        // the endpoints of A are rare, and handled one at a time
+        const int mask_A = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(k, type_bit), zero)));
+        if (mask_A) {
+            uint64_t c_lanes[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(c_lanes), c);
+            for (int m = mask_A; m; m &= m - 1) {
+                const int j = __builtin_ctz(m);
+                n_intersections += update_A(keys[i + j], c_lanes[j], counts);
+            }
+        }
+    }
+    cnt = _mm256_extract_epi64(carry, 0);
+    return n_intersections + update_counts_scalar(keys + i, n - i, cnt, counts);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i count_B_avx512( __m512i k )
+{
+    const __m512i f = _mm512_srli_epi64(k, ep::ID_BITS);
+    const __m512i t = _mm512_and_si512(f, _mm512_set1_epi64(1));
+    const __m512i shift = _mm512_slli_epi64(_mm512_and_si512(_mm512_srli_epi64(f, 1), _mm512_set1_epi64(1)), 5);
+    return _mm512_sllv_epi64(t, shift);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t count_B_avx512( const uint64_t *keys, size_t n )
+{
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i+8 <= n; i += 8) {
+        acc = _mm512_add_epi64(acc, count_B_avx512(_mm512_loadu_si512(keys + i)));
+    }
+    return _mm512_reduce_add_epi64(acc) + count_B_scalar(keys + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t update_counts_avx512( const uint64_t *keys, size_t n, uint64_t cnt, int *counts )
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i type_bit = _mm512_set1_epi64(uint64_t(1) << ep::ID_BITS);
+    const __m512i last = _mm512_set1_epi64(7);
+    __m512i carry = _mm512_set1_epi64(cnt);
+    uint64_t n_intersections = 0;
+    size_t i = 0;
+    for (; i+8 <= n; i += 8) {
+        const __m512i k = _mm512_loadu_si512(keys + i);
+        // inclusive prefix sum of the 8 lanes: shift by 1, 2 and 4 lanes
+        __m512i c = count_B_avx512(k);
+        c = _mm512_add_epi64(c, _mm512_alignr_epi64(c, zero, 7));
+        c = _mm512_add_epi64(c, _mm512_alignr_epi64(c, zero, 6));
+        c = _mm512_add_epi64(c, _mm512_alignr_epi64(c, zero, 4));
+        c = _mm512_add_epi64(c, carry);
+        carry = _mm512_permutexvar_epi64(last, c);
+        const __mmask8 mask_A = _mm512_testn_epi64_mask(k, type_bit);
+        if (mask_A) {
+            uint64_t c_lanes[8];
+            _mm512_storeu_si512(c_lanes, c);
+            for (unsigned m = mask_A; m; m &= m - 1) {
+                const int j = __builtin_ctz(m);
+                n_intersections += update_A(keys[i + j], c_lanes[j], counts);
+            }
+        }
+    }
+    cnt = _mm_cvtsi128_si64(_mm512_castsi512_si128(carry));
+    return n_intersections + update_counts_scalar(keys + i, n - i, cnt, counts);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+static bool isa_supported( simd_isa isa )
+{
+    switch (isa) {
+    case ISA_SCALAR:
+        return true;
+#if HAVE_X86_SIMD
+    case ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case ISA_AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+simd_isa simd_best_isa( void )
+{
+    if (isa_supported(ISA_AVX512))
+        return ISA_AVX512;
+    if (isa_supported(ISA_AVX2))
+        return ISA_AVX2;
+    return ISA_SCALAR;
+}
+
+static simd_isa current_isa = simd_best_isa();
+
+bool simd_set_isa( simd_isa isa )
+{
+    if (!isa_supported(isa))
+        return false;
+    current_isa = isa;
+    return true;
+}
+
+simd_isa simd_get_isa( void )
+{
+    return current_isa;
+}
+
+bool parse_isa( const char *name, simd_isa &isa )
+{
+    for (int i=0; i<N_ISAS; i++) {
+        if (!strcmp(name, isa_names[i])) {
+            isa = simd_isa(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t scan_count_B( const uint64_t *keys, size_t n )
+{
+    switch (current_isa) {
+#if HAVE_X86_SIMD
+    case ISA_AVX512:
+        return count_B_avx512(keys, n);
+    case ISA_AVX2:
+        return count_B_avx2(keys, n);
+#endif
+    default:
+        return count_B_scalar(keys, n);
+    }
+}
+
+uint64_t scan_update_counts( const uint64_t *keys, size_t n, uint64_t cnt, int *counts )
+{
+    switch (current_isa) {
+#if HAVE_X86_SIMD
+    case ISA_AVX512:
+        return update_counts_avx512(keys, n, cnt, counts);
+    case ISA_AVX2:
+        return update_counts_avx2(keys, n, cnt, counts);
+#endif
+    default:
+        return update_counts_scalar(keys, n, cnt, counts);
+    }
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+ *
+ * simd_scan.hh - vectorized scan of the sorted endpoints
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef SIMD_SCAN_HH
+#define SIMD_SCAN_HH
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Instruction sets of the kernels below. By default, the kernels use
+ * the best instruction set supported by the CPU, which is detected
+ * at run time; the other ones are only meant for benchmarking.
+ */
+enum simd_isa {
+    ISA_SCALAR,
+    ISA_AVX2,
+    ISA_AVX512,
+    N_ISAS
+};
+
+extern const char *isa_names[N_ISAS];
+
+/**
+ * Set `isa` to the instruction set called `name`; return false if
+ * there is no such instruction set.
+ */
+bool parse_isa( const char *name, simd_isa &isa );
+
+/**
+ * Return the best instruction set supported by the CPU
+ */
+simd_isa simd_best_isa( void );
+
+/**
+ * Use `isa` in the kernels below; return false (and leave the
+ * current instruction set unchanged) if the CPU does not support it.
+ */
+bool simd_set_isa( simd_isa isa );
+
+simd_isa simd_get_isa( void );
+
+/**
+ * Kernels of the two passes of the blocked scan of count_impl() (see
+ * stl_count.cc), for the 64-bit keys of the intervals with 32-bit
+ * coordinates and 30-bit IDs (type `endpoint` in endpoint.hh).
+ *
+ * scan_count_B() returns the sum of endpoint::count_B() of the keys
+ * in keys[0..n-1], i.e., the packed counter of the endpoints of B in
+ * the block.
+ *
+ * scan_update_counts() rescans keys[0..n-1], where `cnt` is the
+ * counter of the endpoints of B that precede keys[0]: the counter is
+ * updated at each key with an in-register prefix sum, and the counts
+ * of the intervals of A are updated (atomically) at each endpoint of
+ * A. The return value is the contribution of the block to the total
+ * number of intersections, modulo 2^64.
+ */
+uint64_t scan_count_B( const uint64_t *keys, size_t n );
+uint64_t scan_update_counts( const uint64_t *keys, size_t n, uint64_t cnt, int *counts );
+
+#endif /* SIMD_SCAN_HH */
@@ -27,130 +27,541 @@
 #include <numeric>
 #include <algorithm>
 #include <execution>
+#include <omp.h>
 #include "interval.hh"
+#include "interval_set.hh"
 #include "endpoint.hh"
 #include "utils.hh"
 #include "count_intersections.hh"
+#include "aggregate.hh"
+#include "phases.hh"
+#include "trace.hh"
+#include "simd_scan.hh"
+#if RADIX_SORT
+#include "radix_sort.hh"
+#endif
+
+/* Slots of the workspace used by the kernels */
+enum {
+    WS_ENDPOINTS,
+    WS_TMP,
+    WS_BEFORE
+};
 
-struct make_left_endpoint
+/**
+ * Return the array of the 2*(n+m) endpoints of the intervals in `A`
+ * and `B`, sorted with the given execution policy.
+ */
+template<typename ep, class ExecutionPolicy, typename Coord>
+static typename ep::key *sort_endpoints_impl(ExecutionPolicy &&policy,
+                                             const interval_set<Coord> &A,
+                                             const interval_set<Coord> &B,
+                                             count_workspace &ws )
 {
-    endpoint::ep_type t;
+    typedef typename ep::key key;
 
-    make_left_endpoint(endpoint::ep_type t) : t(t) { }
+    const size_t n = A.size();
+    const size_t m = B.size();
+    const size_t n_endpoints = 2*(n+m);
+    assert(n <= ep::MAX_INTERVALS && m <= ep::MAX_INTERVALS);
+    phase_start();
 
-    endpoint operator()(const interval &i) const
-    {
-        return endpoint(i.id, i.left, endpoint::LEFT, t);
+    /* Array of all endpoints. It is taken from the workspace without
+       being initialized, since it is completely overwritten. The
+       coordinates are read from the separate arrays of left and
+       right endpoints, so the loops are easily vectorized. */
+    key *endpoints = ws.get<key>(WS_ENDPOINTS, n_endpoints);
+    const Coord *lA = A.left(), *rA = A.right();
+    const Coord *lB = B.left(), *rB = B.right();
+#pragma omp parallel for
+    for (size_t i=0; i<n; i++) {
+        endpoints[i] = ep::make(i, lA[i], ep::LEFT, ep::SET_A);
+        endpoints[n + i] = ep::make(i, rA[i], ep::RIGHT, ep::SET_A);
     }
-};
+#pragma omp parallel for
+    for (size_t i=0; i<m; i++) {
+        endpoints[2*n + i] = ep::make(i, lB[i], ep::LEFT, ep::SET_B);
+        endpoints[2*n + m + i] = ep::make(i, rB[i], ep::RIGHT, ep::SET_B);
+    }
+    TRACE_BYTES(2*(n+m)*sizeof(Coord) + n_endpoints*sizeof(key));
+    phase_end(PHASE_BUILD);
 
-struct make_right_endpoint
-{
-    endpoint::ep_type t;
+#if RADIX_SORT
+    radix_sort(endpoints, ws.get<key>(WS_TMP, n_endpoints),
+               n_endpoints, ep::ORDER_BIT);
+#else
+    std::sort(policy, endpoints, endpoints + n_endpoints);
+#endif
+    TRACE_BYTES(2*n_endpoints*sizeof(key));
+    phase_end(PHASE_SORT);
+    return endpoints;
+}
 
-    make_right_endpoint(endpoint::ep_type t) : t(t) { }
+/**
+ * The two passes of the blocked scan of count_impl() over the keys in
+ * keys[0..n-1]: scan_block() returns the packed counter of the
+ * endpoints of B; update_block() starts from the counter `cnt` of the
+ * previous blocks, updates `counts` at each endpoint of A, and returns
+ * the contribution of the block to the number of intersections.
+ */
+template<typename ep>
+static typename ep::counter scan_block( const typename ep::key *keys, size_t n )
+{
+    typename ep::counter cnt = 0;
+    for (size_t i=0; i<n; i++) {
+        cnt += ep::count_B(keys[i]);
+    }
+    return cnt;
+}
 
-    endpoint operator()(const interval &i) const
-    {
-        return endpoint(i.id, i.right, endpoint::RIGHT, t);
+template<typename ep, typename Count>
+static size_t update_block( const typename ep::key *keys, size_t n,
+                            typename ep::counter cnt, Count *counts )
+{
+    size_t n_intersections = 0;
+    for (size_t i=0; i<n; i++) {
+        const typename ep::key k = keys[i];
+        cnt += ep::count_B(k);
+        if (ep::type(k) == ep::SET_A) {
+            const size_t id = ep::id(k);
+            if (ep::extreme(k) == ep::LEFT) {
+                const Count nr = ep::nright(cnt);
+#pragma omp atomic
+                counts[id] -= nr;
+                n_intersections -= nr;
+            } else {
+                const Count nl = ep::nleft(cnt);
+#pragma omp atomic
+                counts[id] += nl;
+                n_intersections += nl;
+            }
+        }
     }
-};
+    return n_intersections;
+}
+
+/* The 64-bit keys of the common case use the vectorized kernels of
+   simd_scan.cc */
+template<>
+uint64_t scan_block<endpoint>( const uint64_t *keys, size_t n )
+{
+    return scan_count_B(keys, n);
+}
+
+template<>
+size_t update_block<endpoint, int>( const uint64_t *keys, size_t n,
+                                    uint64_t cnt, int *counts )
+{
+    return scan_update_counts(keys, n, cnt, counts);
+}
 
 /**
- * Count how many intervals in `B` overlap each interval in `A`.
- * The result is stored in the array `counts`.
+ * Count how many intervals in `B` overlap each interval in `A`,
+ * running the STL algorithms with the given execution policy.
  */
-size_t count_intersections(const std::vector<interval> &A,
-                           const std::vector<interval> &B,
-                           std::vector<int> &counts )
+template<class ExecutionPolicy, typename Coord, typename Count>
+static size_t count_impl(ExecutionPolicy &&policy,
+                         const interval_set<Coord> &A,
+                         const interval_set<Coord> &B,
+                         std::vector<Count> &counts,
+                         count_workspace &ws )
 {
+    typedef typename endpoint_for<Coord, Count>::type ep;
+    typedef typename ep::key key;
+
     const size_t n = A.size();
     const size_t m = B.size();
     const size_t n_endpoints = 2*(n+m);
     counts.resize(n);
-    std::cout << "stl_count... " << std::flush;
+    const key *endpoints = sort_endpoints_impl<ep>(policy, A, B, ws);
 
-    // Array of all endpoints
-    std::vector<endpoint> endpoints(n_endpoints);
-#if 0
-#pragma omp parallel
+    /* The number of intersections of the interval in A with id==i is
+       the number of left endpoints of B up to the right endpoint of
+       i, minus the number of right endpoints of B up to the left
+       endpoint of i. Both counters are computed with a single
+       (blocked) parallel scan of the sorted endpoints: each thread
+       first counts the endpoints of B in its block; then, it rescans
+       its block starting from the counts of the previous blocks, and
+       updates `counts` as soon as it meets an endpoint of A. The left
+       and right endpoints of the same interval might be handled by
+       different threads, hence the atomic updates. */
+    std::fill(counts.begin(), counts.end(), 0);
+    std::vector<typename ep::counter> blk_cnt;
+    size_t n_intersections = 0;
+    double t_scan = 0; // end of the first pass, taken by the master thread
+#pragma omp parallel reduction(+:n_intersections)
     {
-#pragma omp for
-        for (size_t i=0; i<n; i++) {
-            const endpoint ep_left(sub[i].id, sub[i].lower, endpoint::LEFT, endpoint::SET_A);
-            const endpoint ep_right(sub[i].id, sub[i].upper, endpoint::RIGHT, endpoint::SET_A);
-            endpoints[i  ] = ep_left;
-            endpoints[i+n] = ep_right;
-        }
-#pragma omp for
-        for (size_t i=0; i<m; i++) {
-            const endpoint ep_left(upd[i].id, upd[i].lower, endpoint::LEFT, endpoint::SET_B);
-            const endpoint ep_right(upd[i].id, upd[i].upper, endpoint::RIGHT, endpoint::SET_B);
-            endpoints[2*n + i  ] = ep_left;
-            endpoints[2*n + i+m] = ep_right;
+        const int n_threads = omp_get_num_threads();
+        const int my_id = omp_get_thread_num();
+        const size_t my_start = n_endpoints * my_id / n_threads;
+        const size_t my_end = n_endpoints * (my_id + 1) / n_threads;
+        typename ep::counter cnt = 0;
+
+#pragma omp single
+        blk_cnt.resize(n_threads + 1);
+
+        TRACE_BEGIN("scan block", "thread");
+        cnt = scan_block<ep>(endpoints + my_start, my_end - my_start);
+        TRACE_BYTES((my_end - my_start)*sizeof(key));
+        TRACE_END();
+        blk_cnt[my_id + 1] = cnt;
+#pragma omp barrier
+#pragma omp master
+        t_scan = now();
+        cnt = 0;
+        for (int t=0; t<=my_id; t++) {
+            cnt += blk_cnt[t];
         }
+
+        TRACE_BEGIN("update block", "thread");
+        n_intersections += update_block<ep>(endpoints + my_start, my_end - my_start,
+                                            cnt, counts.data());
+        TRACE_BYTES((my_end - my_start)*sizeof(key));
+        TRACE_END();
     }
-#else
-    std::transform(std::execution::par,
-                   A.begin(), A.end(),
-                   endpoints.begin(),
-                   make_left_endpoint(endpoint::SET_A));
-    std::transform(std::execution::par,
-                   A.begin(), A.end(),
-                   endpoints.begin() + n,
-                   make_right_endpoint(endpoint::SET_A));
-    std::transform(std::execution::par,
-                   B.begin(), B.end(),
-                   endpoints.begin() + 2*n,
-                   make_left_endpoint(endpoint::SET_B));
-    std::transform(std::execution::par,
-                   B.begin(), B.end(),
-                   endpoints.begin() + 2*n + m,
-                   make_right_endpoint(endpoint::SET_B));
-#endif
+    phase_end_at(PHASE_SCAN, t_scan);
+    phase_end(PHASE_UPDATE);
 
-    std::sort(std::execution::par, endpoints.begin(), endpoints.end());
+    return n_intersections;
+}
 
-    std::vector<int> nleft(n_endpoints);
-    std::vector<int> nright(n_endpoints);
+/**
+ * Same as count_impl(), where the number of intervals of A that
+ * overlap each interval of B is computed as well: the scan keeps a
+ * second packed counter with the endpoints of A seen so far, and
+ * updates the count of each interval of B as soon as it meets one of
+ * its endpoints.
+ */
+template<class ExecutionPolicy, typename Coord, typename Count>
+static size_t count_symmetric_impl(ExecutionPolicy &&policy,
+                                   const interval_set<Coord> &A,
+                                   const interval_set<Coord> &B,
+                                   std::vector<Count> &counts_A,
+                                   std::vector<Count> &counts_B,
+                                   count_workspace &ws )
+{
+    typedef typename endpoint_for<Coord, Count>::type ep;
+    typedef typename ep::key key;
+    typedef typename ep::counter counter;
 
-    /* C++-17 does not provide counted iterators, so there is no
-       STL-compliant way to parallelize the following loop without
-       using an explicit "parallel for" directive */
-#pragma omp parallel for
-    for (size_t i=0; i<n_endpoints; i++) {
-        nleft[i] = nright[i] = 0;
-        if (endpoints[i].t == endpoint::SET_B) {
-            if (endpoints[i].e == endpoint::LEFT)
-                nleft[i] = 1;
-            else
-                nright[i] = 1;
+    const size_t n = A.size();
+    const size_t m = B.size();
+    const size_t n_endpoints = 2*(n+m);
+    counts_A.assign(n, 0);
+    counts_B.assign(m, 0);
+    const key *endpoints = sort_endpoints_impl<ep>(policy, A, B, ws);
+
+    std::vector<counter> blk_A, blk_B;
+    size_t n_intersections = 0;
+    double t_scan = 0;
+#pragma omp parallel reduction(+:n_intersections)
+    {
+        const int n_threads = omp_get_num_threads();
+        const int my_id = omp_get_thread_num();
+        const size_t my_start = n_endpoints * my_id / n_threads;
+        const size_t my_end = n_endpoints * (my_id + 1) / n_threads;
+        counter cnt_A = 0, cnt_B = 0;
+
+#pragma omp single
+        {
+            blk_A.resize(n_threads + 1);
+            blk_B.resize(n_threads + 1);
+        }
+
+        TRACE_BEGIN("scan block", "thread");
+        for (size_t i=my_start; i<my_end; i++) {
+            cnt_A += ep::count_A(endpoints[i]);
+            cnt_B += ep::count_B(endpoints[i]);
+        }
+        TRACE_BYTES((my_end - my_start)*sizeof(key));
+        TRACE_END();
+        blk_A[my_id + 1] = cnt_A;
+        blk_B[my_id + 1] = cnt_B;
+#pragma omp barrier
+#pragma omp master
+        t_scan = now();
+        cnt_A = cnt_B = 0;
+        for (int t=0; t<=my_id; t++) {
+            cnt_A += blk_A[t];
+            cnt_B += blk_B[t];
+        }
+
+        TRACE_BEGIN("update block", "thread");
+        for (size_t i=my_start; i<my_end; i++) {
+            const key k = endpoints[i];
+            cnt_A += ep::count_A(k);
+            cnt_B += ep::count_B(k);
+            const size_t id = ep::id(k);
+            if (ep::type(k) == ep::SET_A) {
+                if (ep::extreme(k) == ep::LEFT) {
+                    const Count nr = ep::nright(cnt_B);
+#pragma omp atomic
+                    counts_A[id] -= nr;
+                    n_intersections -= nr;
+                } else {
+                    const Count nl = ep::nleft(cnt_B);
+#pragma omp atomic
+                    counts_A[id] += nl;
+                    n_intersections += nl;
+                }
+            } else {
+                if (ep::extreme(k) == ep::LEFT) {
+                    const Count nr = ep::nright(cnt_A);
+#pragma omp atomic
+                    counts_B[id] -= nr;
+                } else {
+                    const Count nl = ep::nleft(cnt_A);
+#pragma omp atomic
+                    counts_B[id] += nl;
+                }
+            }
         }
+        TRACE_BYTES((my_end - my_start)*sizeof(key));
+        TRACE_END();
     }
+    phase_end_at(PHASE_SCAN, t_scan);
+    phase_end(PHASE_UPDATE);
 
-    std::inclusive_scan(std::execution::par, nleft.cbegin(), nleft.cend(), nleft.begin(), std::plus<int>());
-    std::inclusive_scan(std::execution::par, nright.cbegin(), nright.cend(), nright.begin(), std::plus<int>());
+    return n_intersections;
+}
+
+/**
+ * Aggregate the values of the intervals in `B` that overlap each
+ * interval in `A` (see aggregate.hh). Same as count_impl(), where the
+ * scan carries two aggregates instead of the packed counter: one over
+ * the left endpoints of B and one over the right endpoints of B. The
+ * left and right endpoints of an interval of A store their value in
+ * two different arrays, so that no atomic update is needed even if
+ * they are handled by different threads; the arrays are then
+ * combined.
+ */
+template<typename ep, typename Op, class ExecutionPolicy, typename Coord>
+static typename Op::value_type aggregate_impl(ExecutionPolicy &&policy,
+                                              const interval_set<Coord> &A,
+                                              const interval_set<Coord> &B,
+                                              const std::vector<typename Op::value_type> &values,
+                                              std::vector<typename Op::value_type> &result,
+                                              count_workspace &ws )
+{
+    typedef typename ep::key key;
+    typedef typename Op::value_type value_type;
 
-    std::vector<int> left_idx(n);
-    std::vector<int> right_idx(n);
+    const size_t n = A.size();
+    const size_t m = B.size();
+    const size_t n_endpoints = 2*(n+m);
+    assert(values.size() >= m);
+    result.resize(n);
+    const key *endpoints = sort_endpoints_impl<ep>(policy, A, B, ws);
+    // before[i] is the aggregate over the right endpoints of B before the left endpoint of i
+    value_type *before = ws.get<value_type>(WS_BEFORE, n);
 
+    std::vector<value_type> blk_left, blk_right;
+    value_type total = Op::identity();
+    double t_scan = 0;
 #pragma omp parallel
     {
-#pragma omp for
-        for (size_t i=0; i<n_endpoints; i++) {
-            if (endpoints[i].t == endpoint::SET_A) {
-                if (endpoints[i].e == endpoint::LEFT)
-                    left_idx[endpoints[i].id] = i;
+        const int n_threads = omp_get_num_threads();
+        const int my_id = omp_get_thread_num();
+        const size_t my_start = n_endpoints * my_id / n_threads;
+        const size_t my_end = n_endpoints * (my_id + 1) / n_threads;
+        value_type agg_left = Op::identity(), agg_right = Op::identity();
+
+#pragma omp single
+        {
+            blk_left.resize(n_threads + 1, Op::identity());
+            blk_right.resize(n_threads + 1, Op::identity());
+        }
+
+        TRACE_BEGIN("scan block", "thread");
+        for (size_t i=my_start; i<my_end; i++) {
+            const key k = endpoints[i];
+            if (ep::type(k) == ep::SET_B) {
+                const value_type v = Op::lift(values[ep::id(k)]);
+                if (ep::extreme(k) == ep::LEFT)
+                    agg_left = Op::combine(agg_left, v);
                 else
-                    right_idx[endpoints[i].id] = i;
+                    agg_right = Op::combine(agg_right, v);
             }
         }
+        TRACE_BYTES((my_end - my_start)*sizeof(key));
+        TRACE_END();
+        blk_left[my_id + 1] = agg_left;
+        blk_right[my_id + 1] = agg_right;
+#pragma omp barrier
+#pragma omp master
+        t_scan = now();
+        agg_left = agg_right = Op::identity();
+        for (int t=0; t<=my_id; t++) {
+            agg_left = Op::combine(agg_left, blk_left[t]);
+            agg_right = Op::combine(agg_right, blk_right[t]);
+        }
+
+        TRACE_BEGIN("update block", "thread");
+        for (size_t i=my_start; i<my_end; i++) {
+            const key k = endpoints[i];
+            const size_t id = ep::id(k);
+            if (ep::type(k) == ep::SET_B) {
+                const value_type v = Op::lift(values[id]);
+                if (ep::extreme(k) == ep::LEFT)
+                    agg_left = Op::combine(agg_left, v);
+                else
+                    agg_right = Op::combine(agg_right, v);
+            } else if (ep::extreme(k) == ep::LEFT) {
+                before[id] = agg_right;
+            } else {
+                result[id] = agg_left;
+            }
+        }
+        TRACE_BYTES((my_end - my_start)*sizeof(key));
+        TRACE_END();
+#pragma omp barrier
+
+        value_type my_total = Op::identity();
 #pragma omp for
         for (size_t i=0; i<n; i++) {
-            counts[i] = nleft[right_idx[i]] - nright[left_idx[i]];
+            result[i] = Op::combine(result[i], Op::inverse(before[i]));
+            my_total = Op::combine(my_total, result[i]);
         }
+#pragma omp critical
+        total = Op::combine(total, my_total);
     }
+    phase_end_at(PHASE_SCAN, t_scan);
+    phase_end(PHASE_UPDATE);
+    return total;
+}
 
-    const int n_intersections = std::reduce(std::execution::par, counts.begin(), counts.end(), 0, std::plus<int>());
-    return n_intersections;
+template<typename Coord, typename Count>
+size_t count_intersections( const interval_set<Coord> &A,
+                            const interval_set<Coord> &B,
+                            std::vector<Count> &counts,
+                            count_workspace *ws )
+{
+    count_workspace local_ws;
+    if (ws == NULL)
+        ws = &local_ws;
+
+    /* When called from inside a parallel region (e.g., to process
+       small contigs concurrently) the kernel runs on the calling
+       thread only: OpenMP regions are serialized anyway, and the STL
+       algorithms are run sequentially. */
+    if (omp_get_level() > 0)
+        return count_impl(std::execution::seq, A, B, counts, *ws);
+
+#if RADIX_SORT
+    std::cout << "stl_count (radix sort)... " << std::flush;
+#else
+    std::cout << "stl_count... " << std::flush;
+#endif
+    return count_impl(std::execution::par, A, B, counts, *ws);
+}
+
+template<typename Coord, typename Count>
+size_t count_intersections_symmetric( const interval_set<Coord> &A,
+                                      const interval_set<Coord> &B,
+                                      std::vector<Count> &counts_A,
+                                      std::vector<Count> &counts_B,
+                                      count_workspace *ws )
+{
+    count_workspace local_ws;
+    if (ws == NULL)
+        ws = &local_ws;
+
+    if (omp_get_level() > 0)
+        return count_symmetric_impl(std::execution::seq, A, B, counts_A, counts_B, *ws);
+
+#if RADIX_SORT
+    std::cout << "stl_count (symmetric, radix sort)... " << std::flush;
+#else
+    std::cout << "stl_count (symmetric)... " << std::flush;
+#endif
+    return count_symmetric_impl(std::execution::par, A, B, counts_A, counts_B, *ws);
+}
+
+template size_t count_intersections( const interval_set<int32_t> &,
+                                     const interval_set<int32_t> &,
+                                     std::vector<int> &,
+                                     count_workspace * );
+/* 64-bit counts and 64-bit coordinates require 128-bit keys */
+#ifdef __SIZEOF_INT128__
+template size_t count_intersections( const interval_set<int32_t> &,
+                                     const interval_set<int32_t> &,
+                                     std::vector<int64_t> &,
+                                     count_workspace * );
+template size_t count_intersections( const interval_set<int64_t> &,
+                                     const interval_set<int64_t> &,
+                                     std::vector<int> &,
+                                     count_workspace * );
+template size_t count_intersections( const interval_set<int64_t> &,
+                                     const interval_set<int64_t> &,
+                                     std::vector<int64_t> &,
+                                     count_workspace * );
+#endif
+
+template size_t count_intersections_symmetric( const interval_set<int32_t> &,
+                                               const interval_set<int32_t> &,
+                                               std::vector<int> &,
+                                               std::vector<int> &,
+                                               count_workspace * );
+#ifdef __SIZEOF_INT128__
+template size_t count_intersections_symmetric( const interval_set<int32_t> &,
+                                               const interval_set<int32_t> &,
+                                               std::vector<int64_t> &,
+                                               std::vector<int64_t> &,
+                                               count_workspace * );
+template size_t count_intersections_symmetric( const interval_set<int64_t> &,
+                                               const interval_set<int64_t> &,
+                                               std::vector<int> &,
+                                               std::vector<int> &,
+                                               count_workspace * );
+template size_t count_intersections_symmetric( const interval_set<int64_t> &,
+                                               const interval_set<int64_t> &,
+                                               std::vector<int64_t> &,
+                                               std::vector<int64_t> &,
+                                               count_workspace * );
+#endif
+
+template<typename Coord, typename Op>
+typename Op::value_type aggregate_intersections( const interval_set<Coord> &A,
+                                                 const interval_set<Coord> &B,
+                                                 const std::vector<typename Op::value_type> &values,
+                                                 std::vector<typename Op::value_type> &result,
+                                                 count_workspace *ws )
+{
+    count_workspace local_ws;
+    if (ws == NULL)
+        ws = &local_ws;
+
+    const bool nested = (omp_get_level() > 0);
+    if (!nested)
+        std::cout << "stl_aggregate... " << std::flush;
+    /* The same keys as count_intersections() are used, so that the IDs
+       of the intervals fit */
+#ifdef __SIZEOF_INT128__
+    if (needs_64bit_counts(A.size(), B.size())) {
+        typedef typename endpoint_for<Coord, int64_t>::type ep;
+        return (nested ?
+                aggregate_impl<ep, Op>(std::execution::seq, A, B, values, result, *ws) :
+                aggregate_impl<ep, Op>(std::execution::par, A, B, values, result, *ws));
+    }
+#endif
+    typedef typename endpoint_for<Coord, int>::type ep;
+    return (nested ?
+            aggregate_impl<ep, Op>(std::execution::seq, A, B, values, result, *ws) :
+            aggregate_impl<ep, Op>(std::execution::par, A, B, values, result, *ws));
 }
+
+#define INSTANTIATE_AGGREGATE(Coord, Op)                                \
+    template Op::value_type aggregate_intersections<Coord, Op>( const interval_set<Coord> &, \
+                                                                const interval_set<Coord> &, \
+                                                                const std::vector<Op::value_type> &, \
+                                                                std::vector<Op::value_type> &, \
+                                                                count_workspace * )
+
+INSTANTIATE_AGGREGATE(int32_t, sum_op<int64_t>);
+INSTANTIATE_AGGREGATE(int32_t, sum_op<double>);
+INSTANTIATE_AGGREGATE(int32_t, sum_of_squares_op<double>);
+#ifdef __SIZEOF_INT128__
+INSTANTIATE_AGGREGATE(int64_t, sum_op<int64_t>);
+INSTANTIATE_AGGREGATE(int64_t, sum_op<double>);
+INSTANTIATE_AGGREGATE(int64_t, sum_of_squares_op<double>);
+#endif
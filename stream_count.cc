@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ * stream_count.cc - count intersections with a single sweep of sorted inputs
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+#include "stream_count.hh"
+
+stream_counter::stream_counter( const std::vector<interval> &A, emit_fn emit ) :
+    A(A), emit(emit), next(0), nleft(0), nright(0), total(0)
+{ }
+
+/**
+ * Open all intervals of A whose left endpoint is <= x. When this is
+ * called, all the intervals of B with left endpoint < x have already
+ * been added, so the number of right endpoints of B that precede the
+ * left endpoint of the newly opened intervals is known.
+ */
+void stream_counter::open_until( int32_t x )
+{
+    while (next < A.size() && A[next].left <= x) {
+        const interval &a = A[next];
+        while (!rights.empty() && rights.top() < a.left) {
+            rights.pop();
+            nright++;
+        }
+        open_interval o;
+        o.right = a.right;
+        o.idx = next;
+        o.nright = nright;
+        open.push(o);
+        next++;
+    }
+    /* Right endpoints that precede the left endpoint of the next
+       interval of A can be counted now; this bounds the size of
+       `rights` by the number of intervals of B that overlap that
+       point. */
+    if (next < A.size()) {
+        while (!rights.empty() && rights.top() < A[next].left) {
+            rights.pop();
+            nright++;
+        }
+    }
+}
+
+/**
+ * Close all the open intervals of A whose right endpoint is < x.
+ * When this is called, all intervals of B with left endpoint < x
+ * have been added, and none with left endpoint >= x.
+ */
+void stream_counter::close_before( int32_t x )
+{
+    while (!open.empty() && open.top().right < x) {
+        const open_interval &o = open.top();
+        const int cnt = nleft - o.nright;
+        total += cnt;
+        emit(o.idx, cnt);
+        open.pop();
+    }
+}
+
+void stream_counter::add( int32_t left, int32_t right )
+{
+    open_until(left);
+    close_before(left);
+    nleft++;
+    // once all intervals of A are open, right endpoints are useless
+    if (next < A.size())
+        rights.push(right);
+    open_until(left);
+}
+
+void stream_counter::finish( void )
+{
+    open_until(INT32_MAX);
+    while (!open.empty()) {
+        const open_interval &o = open.top();
+        const int cnt = nleft - o.nright;
+        total += cnt;
+        emit(o.idx, cnt);
+        open.pop();
+    }
+}
+
+bool sorted_by_left( const std::vector<interval> &A )
+{
+    for (size_t i=1; i<A.size(); i++) {
+        if (A[i-1].left > A[i].left)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ * stream_count.hh - count intersections with a single sweep of sorted inputs
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#ifndef STREAM_COUNT_HH
+#define STREAM_COUNT_HH
+
+#include <cstddef>
+#include <vector>
+#include <queue>
+#include <functional>
+#include "interval.hh"
+
+/**
+ * Counts how many intervals of a stream B overlap each interval of a
+ * set A, where both A and B are sorted by left endpoint. The
+ * intervals of B are not stored: the memory usage only depends on
+ * the maximum number of intervals (of A and B) that overlap the same
+ * point.
+ *
+ * The number of intervals in B that overlap [l, r] in A is the
+ * number of left endpoints of B that are <= r, minus the number of
+ * right endpoints of B that are < l. The first quantity is known as
+ * soon as an interval of B starting after r is seen; the second one
+ * as soon as an interval of B starting at or after l is seen.
+ */
+class stream_counter {
+public:
+    /**
+     * Callback invoked when the count of an interval of A is known;
+     * the arguments are the index of the interval in A and the number
+     * of intervals in B that overlap it.
+     */
+    typedef std::function<void(size_t, int)> emit_fn;
+
+    /**
+     * `A` must be sorted in nondecreasing order of left endpoint, and
+     * must not be modified while the object is in use.
+     */
+    stream_counter( const std::vector<interval> &A, emit_fn emit );
+
+    /**
+     * Add the interval [left, right] of B; the intervals of B must be
+     * added in nondecreasing order of left endpoint.
+     */
+    void add( int32_t left, int32_t right );
+
+    /**
+     * Signal that there are no more intervals in B, and emit the
+     * counts of the intervals of A that are still open.
+     */
+    void finish( void );
+
+    /**
+     * Total number of intersections emitted so far.
+     */
+    size_t n_intersections( void ) const { return total; }
+
+private:
+    struct open_interval {
+        int32_t right;          // right endpoint of the interval in A
+        size_t idx;             // index of the interval in A
+        size_t nright;          // n. of right endpoints of B before its left endpoint
+        bool operator>( const open_interval &other ) const { return right > other.right; }
+    };
+
+    void open_until( int32_t x );
+    void close_before( int32_t x );
+
+    const std::vector<interval> &A;
+    emit_fn emit;
+    size_t next;                // index of the next interval of A to open
+    size_t nleft;               // n. of left endpoints of B seen so far
+    size_t nright;              // n. of right endpoints of B popped from `rights`
+    size_t total;
+    /* right endpoints of the intervals of B that might still be
+       before the left endpoint of some interval of A */
+    std::priority_queue< int32_t, std::vector<int32_t>, std::greater<int32_t> > rights;
+    /* intervals of A whose count is not yet known, by right endpoint */
+    std::priority_queue< open_interval, std::vector<open_interval>, std::greater<open_interval> > open;
+};
+
+/**
+ * Return true iff the intervals in `A` are sorted in nondecreasing
+ * order of left endpoint.
+ */
+bool sorted_by_left( const std::vector<interval> &A );
+
+#endif /* STREAM_COUNT_HH */
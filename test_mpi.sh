@@ -0,0 +1,71 @@
+#!/bin/bash
+
+#
+# Measure the strong and weak scaling of the MPI version on the local
+# host. Run this script as:
+#
+# ./test_mpi.sh
+#
+# The number of MPI processes ranges from 1 to MAX_PROCS (default: the
+# number of processors); each process uses OMP_NUM_THREADS threads
+# (default 1). Options for mpirun can be given in MPIRUN_FLAGS, e.g.:
+#
+# MAX_PROCS=8 MPIRUN_FLAGS="--oversubscribe" ./test_mpi.sh
+#
+# Strong scaling: the total number of intervals is SIZE, regardless of
+# the number of processes. Weak scaling: each process gets
+# SIZE_PER_PROC intervals. The efficiency is computed with respect to
+# the time with one process.
+#
+
+# number of replications
+NREPS=5
+# n. of intervals (strong scaling)
+SIZE=100000000
+# n. of intervals per process (weak scaling)
+SIZE_PER_PROC=20000000
+# where to place test results
+OUT_DIR=test_results
+
+EXE="./intersections_mpi"
+MPIRUN=${MPIRUN:-mpirun}
+MAX_PROCS=${MAX_PROCS:-`cat /proc/cpuinfo | grep processor | wc -l`}
+export OMP_NUM_THREADS=${OMP_NUM_THREADS:-1}
+
+if [ ! -f ${EXE} ]; then
+    echo "FATAL: Missing executable \"${EXE}\""
+    exit 1
+fi
+
+mkdir -p ${OUT_DIR}
+
+for SCALING in strong weak; do
+    FNAME="${OUT_DIR}/`hostname`_mpi_${SCALING}.txt"
+    echo "# Machine: `hostname`" > ${FNAME}
+    echo "# Algorithm: mpi (${SCALING} scaling)" >> ${FNAME}
+    echo "# N. of replications: ${NREPS}" >> ${FNAME}
+    echo "# Threads per process: ${OMP_NUM_THREADS}" >> ${FNAME}
+    echo "# Date: `date`" >> ${FNAME}
+    echo "# Legend:" >> ${FNAME}
+    echo "# P n_intervals time_sec kernel_time_sec efficiency" >> ${FNAME}
+    T1=""
+    for P in `seq 1 $MAX_PROCS` ; do
+        if [ "${SCALING}" = "strong" ]; then
+            N=${SIZE}
+        else
+            N=$(( SIZE_PER_PROC * P ))
+        fi
+        echo -n "mpi ${SCALING} $P/$MAX_PROCS "
+        OUT=$(${MPIRUN} ${MPIRUN_FLAGS} -np $P ${EXE} -r ${NREPS} -N ${N})
+        TIME=$(echo "${OUT}" | grep -i "Intersection time" | egrep -o "[[:digit:]]+\.[[:digit:]]+")
+        KTIME=$(echo "${OUT}" | grep -i "Kernel time" | egrep -o "[[:digit:]]+\.[[:digit:]]+")
+        T1=${T1:-$TIME}
+        if [ "${SCALING}" = "strong" ]; then
+            EFF=$(awk "BEGIN { print $T1 / ($P * $TIME) }")
+        else
+            EFF=$(awk "BEGIN { print $T1 / $TIME }")
+        fi
+        printf "%d %d %s %s %.3f\n" $P $N $TIME $KTIME $EFF >> ${FNAME}
+        echo "$TIME"
+    done
+done
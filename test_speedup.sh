@@ -5,6 +5,29 @@
 #
 # ./test_speedup.sh
 #
+# or, to measure the speedup on real data (contigs are processed
+# concurrently, see option -c):
+#
+# BAM=alignments.bam BED=targets.bed ./test_speedup.sh
+#
+# Set DIST to use a different distribution of the random intervals
+# (see option -g), e.g.:
+#
+# DIST=exome ./test_speedup.sh
+#
+# Each curve is measured with the default placement of the threads
+# and of the memory, and then with each of the following settings,
+# so that their effects can be told apart; the results go to the
+# files with the given suffix:
+#
+# _bind          threads bound to cores (OMP_PROC_BIND, OMP_PLACES)
+# _bind_ft       same, and temporary arrays touched in parallel (-F)
+# _thp           temporary arrays backed by huge pages (-H thp)
+# _bind_ft_thp   all of the above
+#
+# Set PAGES=hugetlb to use the reserved huge pages instead of the
+# transparent huge pages.
+#
 # Last modified 2024-02-13 by Moreno Marzolla
 #
 
@@ -14,6 +37,17 @@ NREPS=5
 SIZE=100000000
 # where to place test results
 OUT_DIR=test_results
+# backing of the temporary arrays with huge pages
+PAGES=${PAGES:-thp}
+
+if [ -n "${BAM}" -a -n "${BED}" ]; then
+    INPUT="-m ${BAM} -d ${BED} -c"
+elif [ -n "${DIST}" ]; then
+    INPUT="-N ${SIZE} -g ${DIST}"
+    SUFFIX="_${DIST}"
+else
+    INPUT="-N ${SIZE}"
+fi
 
 mkdir -p ${OUT_DIR}
 
@@ -25,19 +59,41 @@ for ALGO in omp ; do
         exit 1
     fi
 
-    FNAME="${OUT_DIR}/`hostname`_${ALGO}_speedup.txt"
-    echo "# Machine: `hostname`" > ${FNAME}
-    echo "# Algorithm: ${ALGO}" >> ${FNAME}
-    echo "# N. of replications: ${NREPS}" >> ${FNAME}
-    echo "# Date: `date`" >> ${FNAME}
-    echo "# N of intervals: $SIZE" >> ${FNAME}
-    echo "# Legend:" >> ${FNAME}
-    echo "# P time_sec" >> ${FNAME}
-    NPROC=`cat /proc/cpuinfo | grep processor | wc -l`
-    for P in `seq 1 $NPROC` ; do
-        echo -n "$ALGO $P/$NPROC "
-        TIME=$(OMP_NUM_THREADS=$P ${EXE} -r ${NREPS} -N ${SIZE} | grep -i "Intersection time" | egrep -o "[[:digit:]]+\.[[:digit:]]+")
-        echo "$P $TIME" >> ${FNAME}
-        echo "$TIME"
+    for PLACEMENT in default bind bind_ft ${PAGES} bind_ft_${PAGES} ; do
+        BIND=""
+        FIRST_TOUCH=""
+        HUGE_PAGES=""
+        case "${PLACEMENT}" in
+            bind*) BIND="OMP_PROC_BIND=close OMP_PLACES=cores" ;;
+        esac
+        case "${PLACEMENT}" in
+            *_ft*) FIRST_TOUCH="-F" ;;
+        esac
+        case "${PLACEMENT}" in
+            *${PAGES}) HUGE_PAGES="-H ${PAGES}" ;;
+        esac
+        if [ "${PLACEMENT}" = "default" ]; then
+            PSUFFIX=""
+        else
+            PSUFFIX="_${PLACEMENT}"
+        fi
+        FNAME="${OUT_DIR}/`hostname`_${ALGO}_speedup${SUFFIX}${PSUFFIX}.txt"
+        echo "# Machine: `hostname`" > ${FNAME}
+        echo "# Algorithm: ${ALGO}" >> ${FNAME}
+        echo "# N. of replications: ${NREPS}" >> ${FNAME}
+        echo "# Date: `date`" >> ${FNAME}
+        echo "# Input: ${INPUT}" >> ${FNAME}
+        echo "# Thread binding: ${BIND:-none}" >> ${FNAME}
+        echo "# First touch: ${FIRST_TOUCH:-no}" >> ${FNAME}
+        echo "# Huge pages: ${HUGE_PAGES:-no}" >> ${FNAME}
+        echo "# Legend:" >> ${FNAME}
+        echo "# P time_sec" >> ${FNAME}
+        NPROC=`cat /proc/cpuinfo | grep processor | wc -l`
+        for P in `seq 1 $NPROC` ; do
+            echo -n "$ALGO ${PLACEMENT} $P/$NPROC "
+            TIME=$(env OMP_NUM_THREADS=$P ${BIND} ${EXE} -r ${NREPS} ${INPUT} ${FIRST_TOUCH} ${HUGE_PAGES} | grep -i "Intersection time" | egrep -o "[[:digit:]]+\.[[:digit:]]+")
+            echo "$P $TIME" >> ${FNAME}
+            echo "$TIME"
+        done
     done
 done
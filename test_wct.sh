@@ -9,6 +9,14 @@
 #
 # ./test_wct.sh
 #
+# Set INDEX_BITS to 32 or 64 to force the width of the IDs and counts
+# (see option -b), e.g., to measure the cost of the 64-bit mode:
+#
+# INDEX_BITS=64 ./test_wct.sh
+#
+# Set DIST to use a different distribution of the random intervals
+# (see option -g), e.g., DIST=nested ./test_wct.sh
+#
 # Last modified 2024-02-13 by Moreno Marzolla
 
 # number of replications
@@ -22,6 +30,16 @@ STEP_SIZE=5000000
 # where to place test results
 OUT_DIR=test_results
 
+if [ -n "${INDEX_BITS}" ]; then
+    BITS_OPT="-b ${INDEX_BITS}"
+    SUFFIX="_${INDEX_BITS}bit"
+fi
+
+if [ -n "${DIST}" ]; then
+    DIST_OPT="-g ${DIST}"
+    SUFFIX="${SUFFIX}_${DIST}"
+fi
+
 mkdir -p ${OUT_DIR}
 
 for ALGO in seq omp cuda stl; do
@@ -32,15 +50,17 @@ for ALGO in seq omp cuda stl; do
         exit 1
     fi
 
-    FNAME="${OUT_DIR}/`hostname`_${ALGO}_wct.txt"
+    FNAME="${OUT_DIR}/`hostname`_${ALGO}_wct${SUFFIX}.txt"
     echo "# Machine: `hostname`" > ${FNAME}
     echo "# Algorithm: ${ALGO}" >> ${FNAME}
     echo "# Date: `date`" >> ${FNAME}
+    echo "# Index bits: ${INDEX_BITS:-auto}" >> ${FNAME}
+    echo "# Distribution: ${DIST:-uniform}" >> ${FNAME}
     echo "# Legend:" >> ${FNAME}
     echo "# n_intervals time_sec" >> ${FNAME}
     for SIZE in `seq $FROM_SIZE $STEP_SIZE $TO_SIZE`; do
         echo -n "$ALGO ${SIZE}/${TO_SIZE} "
-        TIME=$(${EXE} -r ${NREPS} -N ${SIZE} | grep -i "Intersection time" | egrep -o "[[:digit:]]+\.[[:digit:]]+")
+        TIME=$(${EXE} -r ${NREPS} ${BITS_OPT} ${DIST_OPT} -N ${SIZE} | grep -i "Intersection time" | egrep -o "[[:digit:]]+\.[[:digit:]]+")
         echo "$SIZE $TIME" >> ${FNAME}
         echo "$TIME"
     done
@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 #include <cassert>
+#include <limits>
 #include <thrust/sort.h>
 #include <thrust/reduce.h>
 #include <thrust/transform_scan.h>
@@ -30,188 +31,660 @@
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/host_vector.h>
 #include <thrust/device_vector.h>
+#include <thrust/device_malloc.h>
+#include <thrust/device_free.h>
+#include <thrust/fill.h>
+#include <thrust/copy.h>
 #include "interval.hh"
+#include "interval_set.hh"
 #include "endpoint.hh"
 #include "utils.hh"
+#include "count_intersections.hh"
+#include "aggregate.hh"
+#include "phases.hh"
+#include "trace.hh"
+#if _OPENMP
+#include <omp.h>
+#endif
+
+/* The radix sort engine works on host memory, so it can only replace
+   th::sort in the Thrust/OpenMP version. The CUDA backend of th::sort
+   already uses a radix sort for primitive keys. */
+#if RADIX_SORT && THRUST_DEVICE_SYSTEM==THRUST_DEVICE_SYSTEM_OMP
+#define USE_RADIX_SORT 1
+#include "radix_sort.hh"
+#else
+#define USE_RADIX_SORT 0
+#endif
 
 namespace th = thrust;
 
+/* Slots of the workspace used by the kernel */
+enum {
+    WS_A_LEFT,
+    WS_A_RIGHT,
+    WS_B_LEFT,
+    WS_B_RIGHT,
+    WS_ENDPOINTS,
+    WS_TMP,
+    WS_CNT,
+    WS_COUNTS,
+    WS_VALUES,
+    WS_BEFORE,
+    WS_COUNTS_B
+};
+
+/* The scratch arrays are allocated in device memory */
+static void *device_alloc( size_t bytes )
+{
+    return th::raw_pointer_cast(th::device_malloc<char>(bytes));
+}
+
+static void device_free( void *p )
+{
+    th::device_free(th::device_pointer_cast(static_cast<char*>(p)));
+}
+
+/* Return an uninitialized device array of n elements of type T from
+   slot `slot` of the workspace */
+template<typename T>
+static th::device_ptr<T> ws_get( count_workspace &ws, size_t slot, size_t n )
+{
+    return th::device_pointer_cast(static_cast<T*>(ws.get_raw(slot, n * sizeof(T), device_alloc, device_free)));
+}
+
 /**
- * This unary function takes an interval as input, and produces a pair
- * of (left, right) endpoints
+ * This unary function takes the index of an interval as input, and
+ * produces a pair of (left, right) endpoints
  */
-typedef typename th::tuple<endpoint, endpoint> pair_of_endpoints;
-
-struct make_endpoint : public th::unary_function< const interval &, pair_of_endpoints >
+template<typename EP>
+struct make_endpoint : public th::unary_function< typename EP::index, th::tuple<typename EP::key, typename EP::key> >
 {
-    endpoint::ep_type ep_type;
+    typedef typename EP::coord coord;
+
+    endpoint_base::ep_type ep_type;
+    const coord *lefts;
+    const coord *rights;
 
     GLOBAL
-    make_endpoint(endpoint::ep_type ep) : ep_type(ep) { }
+    make_endpoint(endpoint_base::ep_type ep, const coord *l, const coord *r) :
+        ep_type(ep), lefts(l), rights(r) { }
 
     GLOBAL
-    pair_of_endpoints operator()(const interval &i) const
+    th::tuple<typename EP::key, typename EP::key> operator()(typename EP::index i) const
     {
-        return th::make_tuple( endpoint(i.id, i.left, endpoint::LEFT, ep_type),
-                               endpoint(i.id, i.right, endpoint::RIGHT, ep_type) );
+        return th::make_tuple( EP::make(i, lefts[i], EP::LEFT, ep_type),
+                               EP::make(i, rights[i], EP::RIGHT, ep_type) );
     }
 };
 
-/* This is a function that maps an endpoint to 1 iff the endpoint is
-   of a given type (SET_A or SET_B) and of a given extreme (left,
-   right). */
-struct init_count : public th::unary_function<const endpoint &, int>
+/* This is a function that maps an endpoint to its contribution to
+   the packed counter of left and right endpoints of B (see
+   endpoint.hh) */
+template<typename EP>
+struct init_count : public th::unary_function<typename EP::key, typename EP::counter>
 {
-    endpoint::ep_type my_ep_type;
-    endpoint::ep_extreme my_ep_extreme;
-
     GLOBAL
-    init_count(endpoint::ep_type t, endpoint::ep_extreme e) :
-        my_ep_type(t),
-        my_ep_extreme(e)
-    { }
-
-    GLOBAL
-    int operator()(const endpoint &ep) const
+    typename EP::counter operator()(typename EP::key ep) const
     {
-        return (ep.t == my_ep_type && ep.e == my_ep_extreme );
+        return EP::count_B(ep);
     }
 };
 
-template<typename Iter>
-struct compute_counts : public th::unary_function<const endpoint &, int > {
+/* Atomically add v to *p */
+GLOBAL
+inline void atomic_add(int *p, int v)
+{
+#ifdef __CUDA_ARCH__
+    atomicAdd(p, v);
+#else
+    __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+#endif
+}
 
-    Iter left_begin, right_begin, nleft_begin, nright_begin;
+GLOBAL
+inline void atomic_add(int64_t *p, int64_t v)
+{
+#ifdef __CUDA_ARCH__
+    atomicAdd(reinterpret_cast<unsigned long long*>(p), (unsigned long long)v);
+#else
+    __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+#endif
+}
 
+template<typename EP, typename Iter_ep, typename Iter_cnt, typename Count>
+struct update_counts
+{
+    Iter_ep ep_begin;
+    Iter_cnt cnt_begin;
+    Count *counts;
+
+    /**
+     * - ep_begin is the iterator that points to the beginning of the
+     *   sorted array of endpoints.
+     *
+     * - cnt_begin is the iterator that points to the beginning of the
+     *   (inclusive) scan of the packed counters.
+     *
+     * - counts points to the array of results, that must be
+     *   initialized with zeros.
+     */
     GLOBAL
-    compute_counts( Iter li, Iter ri, Iter no, Iter nc ) :
-        left_begin(li),
-        right_begin(ri),
-        nleft_begin(no),
-        nright_begin(nc)
+    update_counts( Iter_ep e, Iter_cnt c, Count *cnt ):
+        ep_begin(e),
+        cnt_begin(c),
+        counts(cnt)
     { };
 
     /**
-     * Returns nleft[right[i.id]] - nright[left[i.id]]
+     * If the i-th endpoint is the left endpoint of an interval of A,
+     * subtract the number of right endpoints of B up to i from the
+     * count of that interval; if it is a right endpoint, add the
+     * number of left endpoints of B up to i. The two endpoints of
+     * the same interval might be handled concurrently.
      */
     GLOBAL
-    int operator()(const interval &i) const
+    void operator()(typename EP::index i) const
     {
-        const int idx = i.id;
-        const int ll = *(left_begin + idx);
-        const int rr = *(right_begin + idx);
-        return *(nleft_begin + rr) - *(nright_begin + ll);
+        const typename EP::key ep = *(ep_begin + i);
+        if (EP::type(ep) == EP::SET_A) {
+            const typename EP::index idx = EP::id(ep);
+            const typename EP::counter c = *(cnt_begin + i);
+            if (EP::extreme(ep) == EP::LEFT)
+                atomic_add(counts + idx, Count(-EP::nright(c)));
+            else
+                atomic_add(counts + idx, Count(EP::nleft(c)));
+        }
     }
 };
 
-template<typename Iter_ep, typename Iter_idx>
-struct init_idx
+/* Packed counters of the endpoints of A and of B seen so far during a
+   scan of the sorted endpoints, for the symmetric counts */
+template<typename C>
+struct counter_pair {
+    C a;
+    C b;
+};
+
+template<typename EP>
+struct init_count_pair : public th::unary_function<typename EP::key, counter_pair<typename EP::counter> >
+{
+    GLOBAL
+    counter_pair<typename EP::counter> operator()(typename EP::key ep) const
+    {
+        const counter_pair<typename EP::counter> c = { EP::count_A(ep), EP::count_B(ep) };
+        return c;
+    }
+};
+
+template<typename C>
+struct add_counter_pair
+{
+    GLOBAL
+    counter_pair<C> operator()(const counter_pair<C> &x, const counter_pair<C> &y) const
+    {
+        const counter_pair<C> c = { x.a + y.a, x.b + y.b };
+        return c;
+    }
+};
+
+/* Same as update_counts, where the endpoints of B update the count of
+   their interval with the counter of the endpoints of A */
+template<typename EP, typename Iter_ep, typename Iter_cnt, typename Count>
+struct update_counts_symmetric
 {
-    Iter_idx left_begin, right_begin;
     Iter_ep ep_begin;
+    Iter_cnt cnt_begin;
+    Count *counts_A;
+    Count *counts_B;
 
-    /**
-     * - left_begin is the iterator that points to the left[] array.
-     *
-     * - right_begin is the iterator that points to the right[] array.
-     *
-     * - ep_begin is the iterator that points to the beginning of the
-     *   sorted array of endpoints.
-     */
     GLOBAL
-    init_idx( Iter_ep e, Iter_idx l, Iter_idx r ):
-        left_begin(l),
-        right_begin(r),
-        ep_begin(e)
+    update_counts_symmetric( Iter_ep e, Iter_cnt c, Count *cnt_A, Count *cnt_B ):
+        ep_begin(e),
+        cnt_begin(c),
+        counts_A(cnt_A),
+        counts_B(cnt_B)
     { };
 
     GLOBAL
-    void operator()(int i) const
+    void operator()(typename EP::index i) const
+    {
+        const typename EP::key ep = *(ep_begin + i);
+        const typename EP::index idx = EP::id(ep);
+        const counter_pair<typename EP::counter> c = *(cnt_begin + i);
+        if (EP::type(ep) == EP::SET_A) {
+            if (EP::extreme(ep) == EP::LEFT)
+                atomic_add(counts_A + idx, Count(-EP::nright(c.b)));
+            else
+                atomic_add(counts_A + idx, Count(EP::nleft(c.b)));
+        } else {
+            if (EP::extreme(ep) == EP::LEFT)
+                atomic_add(counts_B + idx, Count(-EP::nright(c.a)));
+            else
+                atomic_add(counts_B + idx, Count(EP::nleft(c.a)));
+        }
+    }
+};
+
+/* Aggregates over the left and the right endpoints of B seen so far
+   during a scan of the sorted endpoints (see aggregate.hh) */
+template<typename V>
+struct agg_pair {
+    V left;
+    V right;
+};
+
+/* Maps an endpoint to its contribution to the aggregates */
+template<typename EP, typename Op>
+struct init_agg : public th::unary_function<typename EP::key, agg_pair<typename Op::value_type> >
+{
+    typedef typename Op::value_type value_type;
+    const value_type *values;
+
+    GLOBAL
+    init_agg( const value_type *v ) : values(v) { }
+
+    GLOBAL
+    agg_pair<value_type> operator()(typename EP::key ep) const
     {
-        const endpoint& ep = *(ep_begin + i);
-        if (ep.t == endpoint::SET_A) {
-            const int idx = ep.id;
-            if (ep.e == endpoint::LEFT)
-                *(left_begin + idx) = i;
+        agg_pair<value_type> a = { Op::identity(), Op::identity() };
+        if (EP::type(ep) == EP::SET_B) {
+            const value_type v = Op::lift(values[EP::id(ep)]);
+            if (EP::extreme(ep) == EP::LEFT)
+                a.left = v;
             else
-                *(right_begin + idx) = i;
+                a.right = v;
         }
+        return a;
+    }
+};
+
+template<typename Op>
+struct combine_agg
+{
+    typedef agg_pair<typename Op::value_type> agg;
+
+    GLOBAL
+    agg operator()(const agg &a, const agg &b) const
+    {
+        const agg c = { Op::combine(a.left, b.left), Op::combine(a.right, b.right) };
+        return c;
+    }
+};
+
+template<typename Op>
+struct combine_values
+{
+    GLOBAL
+    typename Op::value_type operator()(typename Op::value_type a, typename Op::value_type b) const
+    {
+        return Op::combine(a, b);
     }
 };
 
 /**
- * Count how many intervals in `B` overlap each interval in `A`.  The
- * result is stored in the array `counts`.
+ * The left endpoint of an interval of A stores the aggregate over the
+ * right endpoints of B before it in `before`, the right endpoint
+ * stores the aggregate over the left endpoints of B up to it in
+ * `result`. The two endpoints write to different arrays, so no atomic
+ * update is needed.
  */
-size_t count_intersections(const std::vector<interval> &A,
-                           const std::vector<interval> &B,
-                           std::vector<int> &counts )
+template<typename EP, typename Iter_ep, typename Iter_agg, typename Op>
+struct update_agg
 {
-    const size_t n = A.size();
-    const size_t m = B.size();
-    const size_t n_endpoints = 2*(n+m);
-    counts.resize(n);
-#if THRUST_DEVICE_SYSTEM==THRUST_DEVICE_SYSTEM_OMP
-    std::cout << "Thrust/OpenMP... " << std::flush;
+    typedef typename Op::value_type value_type;
+
+    Iter_ep ep_begin;
+    Iter_agg agg_begin;
+    value_type *before;
+    value_type *result;
+
+    GLOBAL
+    update_agg( Iter_ep e, Iter_agg a, value_type *b, value_type *r ):
+        ep_begin(e),
+        agg_begin(a),
+        before(b),
+        result(r)
+    { };
+
+    GLOBAL
+    void operator()(typename EP::index i) const
+    {
+        const typename EP::key ep = *(ep_begin + i);
+        if (EP::type(ep) == EP::SET_A) {
+            const agg_pair<value_type> a = *(agg_begin + i);
+            if (EP::extreme(ep) == EP::LEFT)
+                before[EP::id(ep)] = a.right;
+            else
+                result[EP::id(ep)] = a.left;
+        }
+    }
+};
+
+/* result[i] = result[i] combined with the inverse of before[i] */
+template<typename Op>
+struct finish_agg
+{
+    typedef typename Op::value_type value_type;
+
+    const value_type *before;
+    value_type *result;
+
+    GLOBAL
+    finish_agg( const value_type *b, value_type *r ) : before(b), result(r) { }
+
+    GLOBAL
+    void operator()(size_t i) const
+    {
+        result[i] = Op::combine(result[i], Op::inverse(before[i]));
+    }
+};
+
+/* Print the name of the backend followed by `what`, unless called
+   from inside a parallel region (e.g., to process small contigs
+   concurrently) */
+static void print_banner( const char *what )
+{
+#if _OPENMP
+    if (omp_get_level() > 0)
+        return;
+#endif
+#if THRUST_DEVICE_SYSTEM==THRUST_DEVICE_SYSTEM_OMP && USE_RADIX_SORT
+    std::cout << "Thrust/OpenMP (radix sort)" << what << "... " << std::flush;
+#elif THRUST_DEVICE_SYSTEM==THRUST_DEVICE_SYSTEM_OMP
+    std::cout << "Thrust/OpenMP" << what << "... " << std::flush;
 #elif THRUST_DEVICE_SYSTEM==THRUST_DEVICE_SYSTEM_CPP
-    std::cout << "Thrust/serial... " << std::flush;
+    std::cout << "Thrust/serial" << what << "... " << std::flush;
 #elif THRUST_DEVICE_SYSTEM==THRUST_DEVICE_SYSTEM_CUDA
-    std::cout << "Thrust/CUDA... " << std::flush;
+    std::cout << "Thrust/CUDA" << what << "... " << std::flush;
 #else
     #error Unknown value for THRUST_DEVICE_SYSTEM
 #endif
+}
+
+/**
+ * Copy the coordinates of `A` and `B` to the device, and return the
+ * device array of their 2*(n+m) endpoints, sorted
+ */
+template<typename ep, typename Coord>
+static th::device_ptr<typename ep::key> sort_endpoints_dev( const interval_set<Coord> &A,
+                                                            const interval_set<Coord> &B,
+                                                            count_workspace &ws )
+{
+    typedef typename ep::key key;
+    typedef typename ep::index index;
+
+    const size_t n = A.size();
+    const size_t m = B.size();
+    const size_t n_endpoints = 2*(n+m);
+    assert(n <= ep::MAX_INTERVALS && m <= ep::MAX_INTERVALS);
+    // the endpoints are enumerated by counting iterators of type index
+    assert(n_endpoints <= size_t(std::numeric_limits<index>::max()));
+    phase_start();
 
-    // Array of all endpoints: there are exactly 2*(n+m) pf them
-    th::device_vector<endpoint> d_endpoints(n_endpoints);
+    /* Array of all endpoints: there are exactly 2*(n+m) pf them. All
+       the scratch arrays are taken from the workspace without being
+       initialized, unless stated otherwise. */
+    th::device_ptr<key> d_endpoints = ws_get<key>(ws, WS_ENDPOINTS, n_endpoints);
 
-    th::device_vector<interval> d_A(A);
-    th::device_vector<interval> d_B(B);
+    // Only the coordinates are copied to the device
+    th::device_ptr<Coord> d_lA = ws_get<Coord>(ws, WS_A_LEFT, n);
+    th::device_ptr<Coord> d_rA = ws_get<Coord>(ws, WS_A_RIGHT, n);
+    th::device_ptr<Coord> d_lB = ws_get<Coord>(ws, WS_B_LEFT, m);
+    th::device_ptr<Coord> d_rB = ws_get<Coord>(ws, WS_B_RIGHT, m);
+    th::copy(A.left(), A.left() + n, d_lA);
+    th::copy(A.right(), A.right() + n, d_rA);
+    th::copy(B.left(), B.left() + m, d_lB);
+    th::copy(B.right(), B.right() + m, d_rB);
 
     // Initialize the array of endpoints
-    th::transform(d_A.begin(), d_A.end(),
-                  th::make_zip_iterator(d_endpoints.begin(), d_endpoints.begin() + n),
-                  make_endpoint(endpoint::SET_A));
-    th::transform(d_B.begin(), d_B.end(),
-                  th::make_zip_iterator(d_endpoints.begin() + 2*n, d_endpoints.begin() + 2*n + m),
-                  make_endpoint(endpoint::SET_B));
-
-    th::sort(d_endpoints.begin(), d_endpoints.end());
-
-    /* left_idx[i] is the position (index) in the sorted endpoint
-       array of the left endpoint of the interval in A with id==i;
-
-       right_idx[i] is the position (index) in the sorted endpoint
-       array of the right endpoint of the interval in A with id==i; */
-    th::device_vector<int> left_idx(n), right_idx(n);
-
-    th::for_each( th::make_counting_iterator<int>(0),
-                  th::make_counting_iterator<int>(n_endpoints),
-                  init_idx<th::device_vector<endpoint>::const_iterator, th::device_vector<int>::iterator>(d_endpoints.begin(), left_idx.begin(), right_idx.begin()) );
-
-    /* nleft[i] is the number of left endpoints in B up to and
-       including position i in the array of sorted endpoints */
-    th::device_vector<int> nleft(n_endpoints);
-    /* nright[i] is the number of right endpoints in B up to and
-       including position i in the array of sorted endpoints */
-    th::device_vector<int> nright(n_endpoints);
-
-    th::transform_inclusive_scan( d_endpoints.begin(), d_endpoints.end(),
-                                  nleft.begin(),
-                                  init_count(endpoint::SET_B, endpoint::LEFT),
-                                  th::plus<int>() );
-    th::transform_inclusive_scan( d_endpoints.begin(), d_endpoints.end(),
-                                  nright.begin(),
-                                  init_count(endpoint::SET_B, endpoint::RIGHT),
-                                  th::plus<int>() );
-
-    th::device_vector<int> d_counts(n);
-
-    th::transform( d_A.begin(), d_A.end(),
-                   d_counts.begin(),
-                   compute_counts<th::device_vector<int>::const_iterator>(left_idx.begin(), right_idx.begin(), nleft.begin(), nright.begin() ) );
-
-    th::copy(d_counts.begin(), d_counts.end(), counts.begin());
-
-    const int n_intersections = th::reduce(d_counts.begin(), d_counts.end(), 0);
+    th::transform(th::make_counting_iterator<index>(0),
+                  th::make_counting_iterator<index>(n),
+                  th::make_zip_iterator(d_endpoints, d_endpoints + n),
+                  make_endpoint<ep>(ep::SET_A, th::raw_pointer_cast(d_lA), th::raw_pointer_cast(d_rA)));
+    th::transform(th::make_counting_iterator<index>(0),
+                  th::make_counting_iterator<index>(m),
+                  th::make_zip_iterator(d_endpoints + 2*n, d_endpoints + 2*n + m),
+                  make_endpoint<ep>(ep::SET_B, th::raw_pointer_cast(d_lB), th::raw_pointer_cast(d_rB)));
+    TRACE_BYTES(2*(n+m)*sizeof(Coord) + n_endpoints*sizeof(key));
+    phase_end(PHASE_BUILD);
+
+#if USE_RADIX_SORT
+    radix_sort(th::raw_pointer_cast(d_endpoints),
+               th::raw_pointer_cast(ws_get<key>(ws, WS_TMP, n_endpoints)),
+               n_endpoints, ep::ORDER_BIT);
+#else
+    th::sort(d_endpoints, d_endpoints + n_endpoints);
+#endif
+    TRACE_BYTES(2*n_endpoints*sizeof(key));
+    phase_end(PHASE_SORT);
+    return d_endpoints;
+}
+
+template<typename Coord, typename Count>
+size_t count_intersections( const interval_set<Coord> &A,
+                            const interval_set<Coord> &B,
+                            std::vector<Count> &counts,
+                            count_workspace *ws )
+{
+    typedef typename endpoint_for<Coord, Count>::type ep;
+    typedef typename ep::key key;
+    typedef typename ep::index index;
+
+    count_workspace local_ws;
+    if (ws == NULL)
+        ws = &local_ws;
+
+    const size_t n = A.size();
+    const size_t m = B.size();
+    const size_t n_endpoints = 2*(n+m);
+    counts.resize(n);
+    print_banner("");
+    th::device_ptr<key> d_endpoints = sort_endpoints_dev<ep>(A, B, *ws);
+
+    /* cnt[i] holds the number of left and right endpoints in B up
+       to and including position i in the array of sorted endpoints,
+       packed in a single counter. Both values are computed with a
+       single scan, and the counts of the intervals in A are updated
+       directly from it, without materializing the positions of the
+       endpoints of A. */
+    th::device_ptr<typename ep::counter> cnt = ws_get<typename ep::counter>(*ws, WS_CNT, n_endpoints);
+
+    th::transform_inclusive_scan( d_endpoints, d_endpoints + n_endpoints,
+                                  cnt,
+                                  init_count<ep>(),
+                                  th::plus<typename ep::counter>() );
+    phase_end(PHASE_SCAN);
+
+    // The counts are updated incrementally, so they must be zeroed
+    th::device_ptr<Count> d_counts = ws_get<Count>(*ws, WS_COUNTS, n);
+    th::fill(d_counts, d_counts + n, Count(0));
+
+    th::for_each( th::make_counting_iterator<index>(0),
+                  th::make_counting_iterator<index>(n_endpoints),
+                  update_counts<ep, th::device_ptr<key>, th::device_ptr<typename ep::counter>, Count>(d_endpoints, cnt, th::raw_pointer_cast(d_counts)) );
+    phase_end(PHASE_UPDATE);
+
+    th::copy(d_counts, d_counts + n, counts.begin());
+
+    // the total is accumulated in 64 bits even if the counts are not
+    const size_t n_intersections = th::reduce(d_counts, d_counts + n, size_t(0));
+    phase_end(PHASE_GATHER);
+    return n_intersections;
+}
+
+template<typename Coord, typename Count>
+size_t count_intersections_symmetric( const interval_set<Coord> &A,
+                                      const interval_set<Coord> &B,
+                                      std::vector<Count> &counts_A,
+                                      std::vector<Count> &counts_B,
+                                      count_workspace *ws )
+{
+    typedef typename endpoint_for<Coord, Count>::type ep;
+    typedef typename ep::key key;
+    typedef typename ep::index index;
+    typedef counter_pair<typename ep::counter> cpair;
+
+    count_workspace local_ws;
+    if (ws == NULL)
+        ws = &local_ws;
+
+    const size_t n = A.size();
+    const size_t m = B.size();
+    const size_t n_endpoints = 2*(n+m);
+    counts_A.resize(n);
+    counts_B.resize(m);
+    print_banner(" (symmetric)");
+    th::device_ptr<key> d_endpoints = sort_endpoints_dev<ep>(A, B, *ws);
+
+    // Both packed counters are computed by the same scan
+    th::device_ptr<cpair> cnt = ws_get<cpair>(*ws, WS_CNT, n_endpoints);
+    th::transform_inclusive_scan( d_endpoints, d_endpoints + n_endpoints,
+                                  cnt,
+                                  init_count_pair<ep>(),
+                                  add_counter_pair<typename ep::counter>() );
+    phase_end(PHASE_SCAN);
+
+    th::device_ptr<Count> d_counts_A = ws_get<Count>(*ws, WS_COUNTS, n);
+    th::device_ptr<Count> d_counts_B = ws_get<Count>(*ws, WS_COUNTS_B, m);
+    th::fill(d_counts_A, d_counts_A + n, Count(0));
+    th::fill(d_counts_B, d_counts_B + m, Count(0));
+
+    th::for_each( th::make_counting_iterator<index>(0),
+                  th::make_counting_iterator<index>(n_endpoints),
+                  update_counts_symmetric<ep, th::device_ptr<key>, th::device_ptr<cpair>, Count>(d_endpoints, cnt, th::raw_pointer_cast(d_counts_A), th::raw_pointer_cast(d_counts_B)) );
+    phase_end(PHASE_UPDATE);
+
+    th::copy(d_counts_A, d_counts_A + n, counts_A.begin());
+    th::copy(d_counts_B, d_counts_B + m, counts_B.begin());
+    const size_t n_intersections = th::reduce(d_counts_A, d_counts_A + n, size_t(0));
+    phase_end(PHASE_GATHER);
     return n_intersections;
 }
+
+template size_t count_intersections( const interval_set<int32_t> &,
+                                     const interval_set<int32_t> &,
+                                     std::vector<int> &,
+                                     count_workspace * );
+/* 64-bit counts and 64-bit coordinates require 128-bit keys */
+#ifdef __SIZEOF_INT128__
+template size_t count_intersections( const interval_set<int32_t> &,
+                                     const interval_set<int32_t> &,
+                                     std::vector<int64_t> &,
+                                     count_workspace * );
+template size_t count_intersections( const interval_set<int64_t> &,
+                                     const interval_set<int64_t> &,
+                                     std::vector<int> &,
+                                     count_workspace * );
+template size_t count_intersections( const interval_set<int64_t> &,
+                                     const interval_set<int64_t> &,
+                                     std::vector<int64_t> &,
+                                     count_workspace * );
+#endif
+
+template size_t count_intersections_symmetric( const interval_set<int32_t> &,
+                                               const interval_set<int32_t> &,
+                                               std::vector<int> &,
+                                               std::vector<int> &,
+                                               count_workspace * );
+#ifdef __SIZEOF_INT128__
+template size_t count_intersections_symmetric( const interval_set<int32_t> &,
+                                               const interval_set<int32_t> &,
+                                               std::vector<int64_t> &,
+                                               std::vector<int64_t> &,
+                                               count_workspace * );
+template size_t count_intersections_symmetric( const interval_set<int64_t> &,
+                                               const interval_set<int64_t> &,
+                                               std::vector<int> &,
+                                               std::vector<int> &,
+                                               count_workspace * );
+template size_t count_intersections_symmetric( const interval_set<int64_t> &,
+                                               const interval_set<int64_t> &,
+                                               std::vector<int64_t> &,
+                                               std::vector<int64_t> &,
+                                               count_workspace * );
+#endif
+
+template<typename ep, typename Op, typename Coord>
+static typename Op::value_type aggregate_impl( const interval_set<Coord> &A,
+                                               const interval_set<Coord> &B,
+                                               const std::vector<typename Op::value_type> &values,
+                                               std::vector<typename Op::value_type> &result,
+                                               count_workspace &ws )
+{
+    typedef typename ep::key key;
+    typedef typename ep::index index;
+    typedef typename Op::value_type value_type;
+
+    const size_t n = A.size();
+    const size_t m = B.size();
+    const size_t n_endpoints = 2*(n+m);
+    assert(values.size() >= m);
+    result.resize(n);
+    th::device_ptr<key> d_endpoints = sort_endpoints_dev<ep>(A, B, ws);
+
+    th::device_ptr<value_type> d_values = ws_get<value_type>(ws, WS_VALUES, m);
+    th::copy(values.begin(), values.begin() + m, d_values);
+
+    /* The aggregates over the left and right endpoints of B are
+       computed with a single scan, as the packed counters of
+       count_intersections() */
+    th::device_ptr< agg_pair<value_type> > agg = ws_get< agg_pair<value_type> >(ws, WS_CNT, n_endpoints);
+    th::transform_inclusive_scan( d_endpoints, d_endpoints + n_endpoints,
+                                  agg,
+                                  init_agg<ep, Op>(th::raw_pointer_cast(d_values)),
+                                  combine_agg<Op>() );
+    phase_end(PHASE_SCAN);
+
+    th::device_ptr<value_type> d_before = ws_get<value_type>(ws, WS_BEFORE, n);
+    th::device_ptr<value_type> d_result = ws_get<value_type>(ws, WS_COUNTS, n);
+    th::for_each( th::make_counting_iterator<index>(0),
+                  th::make_counting_iterator<index>(n_endpoints),
+                  update_agg<ep, th::device_ptr<key>, th::device_ptr< agg_pair<value_type> >, Op>(d_endpoints, agg, th::raw_pointer_cast(d_before), th::raw_pointer_cast(d_result)) );
+    th::for_each( th::make_counting_iterator<size_t>(0),
+                  th::make_counting_iterator<size_t>(n),
+                  finish_agg<Op>(th::raw_pointer_cast(d_before), th::raw_pointer_cast(d_result)) );
+    phase_end(PHASE_UPDATE);
+
+    th::copy(d_result, d_result + n, result.begin());
+    const value_type total = th::reduce(d_result, d_result + n, Op::identity(), combine_values<Op>());
+    phase_end(PHASE_GATHER);
+    return total;
+}
+
+template<typename Coord, typename Op>
+typename Op::value_type aggregate_intersections( const interval_set<Coord> &A,
+                                                 const interval_set<Coord> &B,
+                                                 const std::vector<typename Op::value_type> &values,
+                                                 std::vector<typename Op::value_type> &result,
+                                                 count_workspace *ws )
+{
+    count_workspace local_ws;
+    if (ws == NULL)
+        ws = &local_ws;
+
+    print_banner(" aggregate");
+    /* The same keys as count_intersections() are used, so that the IDs
+       of the intervals fit */
+#ifdef __SIZEOF_INT128__
+    if (needs_64bit_counts(A.size(), B.size()))
+        return aggregate_impl<typename endpoint_for<Coord, int64_t>::type, Op>(A, B, values, result, *ws);
+#endif
+    return aggregate_impl<typename endpoint_for<Coord, int>::type, Op>(A, B, values, result, *ws);
+}
+
+#define INSTANTIATE_AGGREGATE(Coord, Op)                                \
+    template Op::value_type aggregate_intersections<Coord, Op>( const interval_set<Coord> &, \
+                                                                const interval_set<Coord> &, \
+                                                                const std::vector<Op::value_type> &, \
+                                                                std::vector<Op::value_type> &, \
+                                                                count_workspace * )
+
+INSTANTIATE_AGGREGATE(int32_t, sum_op<int64_t>);
+INSTANTIATE_AGGREGATE(int32_t, sum_op<double>);
+INSTANTIATE_AGGREGATE(int32_t, sum_of_squares_op<double>);
+#ifdef __SIZEOF_INT128__
+INSTANTIATE_AGGREGATE(int64_t, sum_op<int64_t>);
+INSTANTIATE_AGGREGATE(int64_t, sum_op<double>);
+INSTANTIATE_AGGREGATE(int64_t, sum_of_squares_op<double>);
+#endif
@@ -0,0 +1,277 @@
+/****************************************************************************
+ *
+ * trace.cc - opt-in instrumentation of the kernels
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#if INSTRUMENT
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "utils.hh"
+#include "trace.hh"
+
+enum { CTR_CYCLES, CTR_LLC_MISSES, CTR_BRANCH_MISSES, N_COUNTERS };
+
+static const char *counter_names[N_COUNTERS] = { "cycles", "llc_misses", "branch_misses" };
+
+static const uint64_t counter_config[N_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/* While an event is open, `ctr` holds the values of the counters at
+   the beginning of the event; when it ends, their differences. */
+struct event {
+    std::string name;
+    const char *cat;
+    double t_begin, t_end;
+    size_t bytes;
+    uint64_t ctr[N_COUNTERS];
+};
+
+/* Events of a single thread; the per-thread counters are opened when
+   the thread records its first event. */
+struct thread_trace {
+    long tid;
+    int fd[N_COUNTERS];
+    std::vector<event> stack;   // open events, innermost last
+    std::vector<event> events;  // completed events
+    event mark;                 // event started by trace_mark()
+    bool has_mark;
+};
+
+static std::atomic<bool> active(false);
+static std::mutex threads_lock;     // protects `threads`
+static std::vector<thread_trace*> threads;
+static std::string trace_file_name;
+static double t_origin;
+static thread_local thread_trace *my_trace = NULL;
+
+static int open_counter( uint64_t config )
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // pid == 0, cpu == -1: the calling thread, on any CPU
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static thread_trace *get_thread_trace( void )
+{
+    if (my_trace == NULL) {
+        static bool warned = false;
+        thread_trace *t = new thread_trace;
+        t->tid = syscall(SYS_gettid);
+        t->has_mark = false;
+        for (int c=0; c<N_COUNTERS; c++) {
+            t->fd[c] = open_counter(counter_config[c]);
+        }
+        std::lock_guard<std::mutex> guard(threads_lock);
+        if (t->fd[CTR_CYCLES] < 0 && !warned) {
+            std::cerr << "WARNING: perf_event_open() failed (" << strerror(errno)
+                      << "); the hardware counters are not recorded" << std::endl;
+            warned = true;
+        }
+        threads.push_back(t);
+        my_trace = t;
+    }
+    return my_trace;
+}
+
+static void read_counters( const thread_trace *t, uint64_t *ctr )
+{
+    for (int c=0; c<N_COUNTERS; c++) {
+        ctr[c] = 0;
+        if (t->fd[c] >= 0 && read(t->fd[c], &ctr[c], sizeof(ctr[c])) != sizeof(ctr[c]))
+            ctr[c] = 0;
+    }
+}
+
+static void start_event( thread_trace *t, event &e, const char *cat, double t_begin )
+{
+    e.cat = cat;
+    e.t_begin = t_begin;
+    e.bytes = 0;
+    read_counters(t, e.ctr);
+}
+
+static void finish_event( thread_trace *t, event &e, double t_end )
+{
+    uint64_t ctr[N_COUNTERS];
+    read_counters(t, ctr);
+    for (int c=0; c<N_COUNTERS; c++)
+        e.ctr[c] = ctr[c] - e.ctr[c];
+    e.t_end = t_end;
+    t->events.push_back(e);
+}
+
+bool trace_start( const char *file_name )
+{
+    std::ofstream out(file_name);
+    if (!out)
+        return false;
+    std::lock_guard<std::mutex> guard(threads_lock);
+    for (size_t i=0; i<threads.size(); i++) {
+        threads[i]->stack.clear();
+        threads[i]->events.clear();
+        threads[i]->has_mark = false;
+    }
+    trace_file_name = file_name;
+    t_origin = now();
+    active = true;
+    return true;
+}
+
+static void write_string( std::ostream &out, const std::string &s )
+{
+    out << '"';
+    for (size_t i=0; i<s.size(); i++) {
+        const char ch = s[i];
+        if (ch == '"' || ch == '\\')
+            out << '\\' << ch;
+        else if ((unsigned char)ch < 0x20)
+            out << ' ';
+        else
+            out << ch;
+    }
+    out << '"';
+}
+
+bool trace_stop( void )
+{
+    if (!active)
+        return false;
+    active = false;
+    std::ofstream out(trace_file_name.c_str());
+    const long pid = getpid();
+    bool first = true;
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    std::lock_guard<std::mutex> guard(threads_lock);
+    for (size_t i=0; i<threads.size(); i++) {
+        const thread_trace *t = threads[i];
+        out << (first ? "" : ",\n")
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+            << ", \"tid\": " << t->tid << ", \"args\": {\"name\": \"thread " << i << "\"}}";
+        first = false;
+        for (size_t j=0; j<t->events.size(); j++) {
+            const event &e = t->events[j];
+            // Chrome traces are in microseconds
+            const double dur = e.t_end - e.t_begin;
+            out << ",\n{\"name\": ";
+            write_string(out, e.name);
+            out << ", \"cat\": \"" << e.cat << "\", \"ph\": \"X\""
+                << ", \"ts\": " << (e.t_begin - t_origin) * 1e6
+                << ", \"dur\": " << dur * 1e6
+                << ", \"pid\": " << pid << ", \"tid\": " << t->tid
+                << ", \"args\": {\"bytes\": " << e.bytes;
+            if (dur > 0)
+                out << ", \"GB/s\": " << e.bytes / dur / 1e9;
+            for (int c=0; c<N_COUNTERS; c++) {
+                if (t->fd[c] >= 0)
+                    out << ", \"" << counter_names[c] << "\": " << e.ctr[c];
+            }
+            out << "}}";
+        }
+    }
+    out << "\n]}" << std::endl;
+    return bool(out);
+}
+
+void trace_begin( const char *name, const char *cat )
+{
+    if (active)
+        trace_begin(std::string(name), cat);
+}
+
+void trace_begin( const std::string &name, const char *cat )
+{
+    if (!active)
+        return;
+    thread_trace *t = get_thread_trace();
+    t->stack.push_back(event());
+    event &e = t->stack.back();
+    e.name = name;
+    start_event(t, e, cat, now());
+}
+
+void trace_end( void )
+{
+    if (!active)
+        return;
+    thread_trace *t = get_thread_trace();
+    // the event might have begun before trace_start()
+    if (t->stack.empty())
+        return;
+    finish_event(t, t->stack.back(), now());
+    t->stack.pop_back();
+}
+
+void trace_bytes( size_t bytes )
+{
+    if (!active)
+        return;
+    thread_trace *t = get_thread_trace();
+    const bool to_mark = t->has_mark && (t->stack.empty() || t->mark.t_begin >= t->stack.back().t_begin);
+    if (to_mark)
+        t->mark.bytes += bytes;
+    else if (!t->stack.empty())
+        t->stack.back().bytes += bytes;
+}
+
+void trace_mark( void )
+{
+    if (!active)
+        return;
+    thread_trace *t = get_thread_trace();
+    start_event(t, t->mark, "", now());
+    t->has_mark = true;
+}
+
+void trace_mark_event( const char *name, const char *cat, double t_end )
+{
+    if (!active)
+        return;
+    thread_trace *t = get_thread_trace();
+    if (t->has_mark) {
+        t->mark.name = name;
+        t->mark.cat = cat;
+        finish_event(t, t->mark, t_end);
+    }
+    start_event(t, t->mark, "", t_end);
+    t->has_mark = true;
+}
+
+#endif
@@ -0,0 +1,98 @@
+/****************************************************************************
+ *
+ * trace.hh - opt-in instrumentation of the kernels
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+
+#ifndef TRACE_HH
+#define TRACE_HH
+
+/**
+ * Opt-in instrumentation of the kernels and of the main loop, enabled
+ * at compile time with INSTRUMENT=1 (e.g., "make INSTRUMENT=1 all");
+ * otherwise, the macros below compile to nothing.
+ *
+ * While a trace is active (see trace_start()), each event records
+ * the wall-clock time, the number of bytes touched (as declared with
+ * TRACE_BYTES) and, when perf_event_open() is available, the number
+ * of CPU cycles, last-level cache misses and branch misses of the
+ * calling thread. Events are recorded per thread, and are written in
+ * the Chrome trace event format by trace_stop(); the file can be
+ * opened with chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Events can be nested; the name and category of an event must be
+ * string literals, except for the names given to TRACE_BEGIN_STR.
+ */
+#if INSTRUMENT
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Start recording events; they are written to `file_name` by
+ * trace_stop(). Return false if the file can not be created.
+ */
+bool trace_start( const char *file_name );
+
+/**
+ * Stop recording events, and write the trace file. Return false on
+ * error.
+ */
+bool trace_stop( void );
+
+/**
+ * Begin and end an event of the calling thread. trace_bytes() adds
+ * `bytes` to the event of the calling thread that started last,
+ * either an open event or the one started by trace_mark().
+ */
+void trace_begin( const char *name, const char *cat );
+void trace_begin( const std::string &name, const char *cat );
+void trace_end( void );
+void trace_bytes( size_t bytes );
+
+/**
+ * trace_mark_event() records the event `name` from the previous call
+ * to trace_mark() or trace_mark_event() by the calling thread to time
+ * `t` (as returned by now()), and starts the next event; this is how
+ * the phases of the kernels are recorded (see phases.cc). The
+ * counters are read when trace_mark_event() is called.
+ */
+void trace_mark( void );
+void trace_mark_event( const char *name, const char *cat, double t );
+
+#define TRACE_BEGIN(name, cat) trace_begin((name), (cat))
+#define TRACE_BEGIN_STR(name, cat) trace_begin(std::string(name), (cat))
+#define TRACE_END() trace_end()
+#define TRACE_BYTES(bytes) trace_bytes(bytes)
+#define TRACE_MARK() trace_mark()
+#define TRACE_MARK_EVENT(name, cat, t) trace_mark_event((name), (cat), (t))
+
+#else
+
+#define TRACE_BEGIN(name, cat) do { } while (0)
+#define TRACE_BEGIN_STR(name, cat) do { } while (0)
+#define TRACE_END() do { } while (0)
+#define TRACE_BYTES(bytes) do { } while (0)
+#define TRACE_MARK() do { } while (0)
+#define TRACE_MARK_EVENT(name, cat, t) do { } while (0)
+
+#endif
+
+#endif /* TRACE_HH */
@@ -0,0 +1,181 @@
+/****************************************************************************
+ *
+ * workspace.cc - reusable scratch memory for the counting kernels
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <atomic>
+#include <iostream>
+#include <algorithm>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "workspace.hh"
+
+/* Blocks are aligned to the size of a cache line */
+static const size_t ALIGNMENT = 64;
+
+/* Size of the huge pages of MAP_HUGETLB (the default on x86-64) */
+static const size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+const char *pages_names[N_PAGES] = { "default", "thp", "hugetlb" };
+
+/* Placement of the blocks in host memory (see workspace_set_placement()) */
+static bool first_touch = false;
+static huge_pages_t huge_pages = PAGES_DEFAULT;
+
+bool parse_pages( const char *name, huge_pages_t &pages )
+{
+    for (int i=0; i<N_PAGES; i++) {
+        if (!strcmp(name, pages_names[i])) {
+            pages = huge_pages_t(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void workspace_set_placement( bool touch, huge_pages_t pages )
+{
+    first_touch = touch;
+    huge_pages = pages;
+}
+
+count_workspace::count_workspace( ):
+    cur_bytes(0),
+    max_bytes(0)
+{ }
+
+count_workspace::~count_workspace( )
+{
+    release();
+}
+
+void *count_workspace::host_alloc( size_t bytes )
+{
+    void *p = NULL;
+    if (posix_memalign(&p, ALIGNMENT, bytes) != 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+void count_workspace::host_free( void *p )
+{
+    free(p);
+}
+
+/* The first ALIGNMENT bytes of the mapping hold its length, which is
+   needed by munmap() */
+void *count_workspace::placed_alloc( size_t bytes )
+{
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    const size_t granule = (huge_pages == PAGES_DEFAULT ? page_size : HUGE_PAGE_SIZE);
+    const size_t len = (bytes + ALIGNMENT + granule - 1) / granule * granule;
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (huge_pages == PAGES_HUGETLB) {
+        static std::atomic<bool> warned(false);
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED && !warned.exchange(true)) {
+            std::cerr << "WARNING: mmap(MAP_HUGETLB) failed (" << strerror(errno)
+                      << "), using regular pages; see /proc/sys/vm/nr_hugepages" << std::endl;
+        }
+    }
+#endif
+    if (p == MAP_FAILED)
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    if (huge_pages == PAGES_THP)
+        madvise(p, len, MADV_HUGEPAGE);
+#endif
+    char *base = static_cast<char*>(p);
+    *reinterpret_cast<size_t*>(base) = len;
+    return base + ALIGNMENT;
+}
+
+void count_workspace::placed_free( void *p )
+{
+    char *base = static_cast<char*>(p) - ALIGNMENT;
+    munmap(base, *reinterpret_cast<size_t*>(base));
+}
+
+/* Touch the pages of p[0..bytes-1] in parallel; the static schedule
+   gives each thread a contiguous range of pages, as the blocked scans
+   of the kernels split an array of `bytes` bytes */
+static void touch_pages( void *p, size_t bytes )
+{
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    char *first = static_cast<char*>(p);
+    const size_t n_pages = (bytes + page_size - 1) / page_size;
+#pragma omp parallel for schedule(static)
+    for (size_t i=0; i<n_pages; i++) {
+        first[i * page_size] = 0;
+    }
+}
+
+void *count_workspace::get_raw( size_t slot, size_t bytes, alloc_fn alloc, free_fn dealloc )
+{
+    if (alloc == NULL) {
+        const bool placed = (first_touch || huge_pages != PAGES_DEFAULT);
+        alloc = (placed ? placed_alloc : host_alloc);
+        dealloc = (placed ? placed_free : host_free);
+    }
+    if (slot >= blocks.size()) {
+        const block empty = { NULL, 0, NULL };
+        blocks.resize(slot + 1, empty);
+    }
+    block &b = blocks[slot];
+    if (b.ptr != NULL && b.bytes >= bytes && b.dealloc == dealloc)
+        return b.ptr;
+
+    /* Grow by at least 50%, so that a sequence of slightly larger
+       requests (e.g., contigs of increasing size) does not cause a
+       reallocation every time. A block that is only replaced because
+       it comes from a different allocator keeps its size. */
+    const size_t grown = (b.bytes >= bytes ? b.bytes : std::max(bytes, b.bytes + b.bytes/2));
+    const size_t new_bytes = std::max(grown, ALIGNMENT);
+    if (b.ptr != NULL) {
+        b.dealloc(b.ptr);
+        cur_bytes -= b.bytes;
+        b.ptr = NULL;
+        b.bytes = 0;
+    }
+    b.ptr = alloc(new_bytes);
+    if (first_touch && dealloc == placed_free)
+        touch_pages(b.ptr, bytes);
+    b.bytes = new_bytes;
+    b.dealloc = dealloc;
+    cur_bytes += new_bytes;
+    max_bytes = std::max(max_bytes, cur_bytes);
+    return b.ptr;
+}
+
+void count_workspace::release( void )
+{
+    for (size_t i=0; i<blocks.size(); i++) {
+        if (blocks[i].ptr != NULL)
+            blocks[i].dealloc(blocks[i].ptr);
+    }
+    blocks.clear();
+    cur_bytes = 0;
+}
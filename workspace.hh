@@ -0,0 +1,146 @@
+/****************************************************************************
+ *
+ * workspace.hh - reusable scratch memory for the counting kernels
+ *
+ * Copyright (C) 2025 Moreno Marzolla, Giovanni Birolo, Gabriele D'Angelo, Piero Fariselli
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************************/
+
+
+#ifndef WORKSPACE_HH
+#define WORKSPACE_HH
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Backing of the host memory of the workspaces: regular pages,
+ * transparent huge pages (the kernel is advised to use huge pages,
+ * see madvise(2)) or huge pages from the pool reserved by the
+ * administrator (see /proc/sys/vm/nr_hugepages); if the pool is
+ * empty, regular pages are used.
+ */
+enum huge_pages_t {
+    PAGES_DEFAULT,
+    PAGES_THP,
+    PAGES_HUGETLB,
+    N_PAGES
+};
+
+extern const char *pages_names[N_PAGES];
+
+/**
+ * Set `pages` to the backing called `name`; return false if there is
+ * no such backing.
+ */
+bool parse_pages( const char *name, huge_pages_t &pages );
+
+/**
+ * Set the placement of the blocks allocated in host memory from now
+ * on, by all workspaces. With `first_touch`, when a new block is
+ * allocated, the requested bytes are touched in parallel by the
+ * threads of the current team, each one touching a contiguous range
+ * as in the (blocked) static schedule of the kernels; with threads
+ * bound to cores (e.g., OMP_PROC_BIND=close), each page then lands on
+ * the NUMA node of the thread that will scan it. A block that is
+ * reused for a smaller request (e.g., a smaller contig) keeps its
+ * placement, which then only approximately matches the threads. By
+ * default, blocks are allocated with regular pages and are not
+ * touched.
+ */
+void workspace_set_placement( bool first_touch, huge_pages_t pages );
+
+/**
+ * Scratch memory for the counting kernels, that can be reused across
+ * calls (e.g., across contigs and replications) to avoid allocating
+ * and initializing the temporary arrays every time.
+ *
+ * The memory is organized in numbered slots, one for each temporary
+ * array of a kernel. A slot only grows: if a kernel asks for a slot
+ * that is smaller than needed, the old block is released and a new,
+ * larger one is allocated. The content of a slot is not initialized,
+ * and is not preserved across calls. The workspace can not be used
+ * by multiple threads at the same time.
+ */
+class count_workspace {
+public:
+    typedef void *(*alloc_fn)( size_t );
+    typedef void (*free_fn)( void * );
+
+    count_workspace();
+    ~count_workspace();
+
+    /**
+     * Return a block of (at least) `bytes` bytes for slot `slot`. New
+     * blocks are obtained from `alloc` and released with `dealloc`,
+     * so that a kernel can keep its scratch arrays in device memory;
+     * by default, blocks are allocated in host memory, with the
+     * placement set by workspace_set_placement(). A block that is
+     * large enough but comes from a different allocator is replaced
+     * by one of the same size, so that host and device users can
+     * alternate on a slot without growing it.
+     */
+    void *get_raw( size_t slot, size_t bytes,
+                   alloc_fn alloc = NULL, free_fn dealloc = NULL );
+
+    /**
+     * Return an array of (at least) `n` elements of type T for slot
+     * `slot`, allocated in host memory.
+     */
+    template<typename T>
+    T *get( size_t slot, size_t n )
+    {
+        return static_cast<T*>(get_raw(slot, n * sizeof(T)));
+    }
+
+    /**
+     * Release all blocks.
+     */
+    void release( void );
+
+    /**
+     * Total number of bytes currently allocated.
+     */
+    size_t size( void ) const { return cur_bytes; }
+
+    /**
+     * Maximum number of bytes allocated at the same time so far.
+     */
+    size_t high_water_mark( void ) const { return max_bytes; }
+
+    static void *host_alloc( size_t bytes );
+    static void host_free( void *p );
+
+    /* Allocate with mmap(), with the placement set by
+       workspace_set_placement() */
+    static void *placed_alloc( size_t bytes );
+    static void placed_free( void *p );
+
+private:
+    count_workspace( const count_workspace & );
+    count_workspace& operator=( const count_workspace & );
+
+    struct block {
+        void *ptr;
+        size_t bytes;
+        free_fn dealloc;
+    };
+    std::vector<block> blocks;
+    size_t cur_bytes;
+    size_t max_bytes;
+};
+
+#endif /* WORKSPACE_HH */